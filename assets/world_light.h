@@ -0,0 +1,135 @@
+// Generated by `make bake` from the rooms in src/world.h. Do not edit
+#ifndef WORLD_LIGHT_H
+#define WORLD_LIGHT_H
+
+#include "../src/light.h"
+
+static float WORLD_LIGHT_DATA[720] = {
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f, 1.851851940e-01f,
+    0.000000000e+00f, 4.166666567e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f,
+    4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f,
+    9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f,
+    1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f,
+    3.750000000e+00f, 1.500000000e+01f, 1.500000000e+01f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f,
+    2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f, 1.851851940e-01f,
+    0.000000000e+00f, 4.166666567e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f,
+    4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f,
+    9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f,
+    1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f,
+    3.750000000e+00f, 1.500000000e+01f, 1.500000000e+01f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f,
+    2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f, 1.851851940e-01f,
+    0.000000000e+00f, 4.166666567e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f,
+    4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f,
+    9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f,
+    1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f,
+    3.750000000e+00f, 1.500000000e+01f, 1.500000000e+01f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f,
+    2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f, 1.851851940e-01f,
+    0.000000000e+00f, 4.166666567e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f,
+    4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f,
+    9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f,
+    1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f,
+    3.750000000e+00f, 1.500000000e+01f, 1.500000000e+01f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f,
+    1.851851940e-01f, 2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f,
+    2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f,
+    3.061224520e-01f, 4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f,
+    4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f,
+    9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f,
+    1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 1.500000000e+01f, 1.500000000e+01f, 3.750000000e+00f,
+    1.851851940e-01f, 2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f,
+    2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f,
+    3.061224520e-01f, 4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f,
+    4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f,
+    9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f,
+    1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 1.500000000e+01f, 1.500000000e+01f, 3.750000000e+00f,
+    1.851851940e-01f, 2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f,
+    2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f,
+    3.061224520e-01f, 4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f,
+    4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f,
+    9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f,
+    1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 1.500000000e+01f, 1.500000000e+01f, 3.750000000e+00f,
+    1.851851940e-01f, 2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 3.061224520e-01f, 2.343750000e-01f,
+    2.343750000e-01f, 3.061224520e-01f, 4.166666567e-01f, 5.999999642e-01f, 4.166666567e-01f, 3.061224520e-01f,
+    3.061224520e-01f, 4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 4.166666567e-01f,
+    4.166666567e-01f, 5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.666666627e+00f, 9.375000000e-01f,
+    9.375000000e-01f, 1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 3.750000000e+00f, 1.666666627e+00f,
+    1.666666627e+00f, 3.750000000e+00f, 1.500000000e+01f, 1.500000000e+01f, 1.500000000e+01f, 3.750000000e+00f,
+    1.999999881e-01f, 3.125000000e-01f, 1.999999881e-01f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    3.125000000e-01f, 5.555555820e-01f, 3.125000000e-01f, 1.999999881e-01f, 0.000000000e+00f, 1.614379048e+00f,
+    1.136732101e+00f, 2.158088207e+00f, 5.555555820e-01f, 3.944852829e+00f, 1.472941113e+01f, 3.632352829e+00f,
+    2.158088207e+00f, 6.614378929e+00f, 4.882352829e+00f, 1.508496666e+01f, 1.484191132e+01f, 1.472941113e+01f,
+    5.581176281e+00f, 5.908088207e+00f, 6.614378929e+00f, 4.882352829e+00f, 1.508496666e+01f, 3.944852829e+00f,
+    1.653594732e+00f, 5.581176281e+00f, 2.158088207e+00f, 2.169934750e+00f, 3.944852829e+00f, 1.814378977e+00f,
+    8.520742059e-01f, 1.653594732e+00f, 1.136732101e+00f, 1.220588207e+00f, 1.814378977e+00f, 1.046977043e+00f,
+    5.395220518e-01f, 8.520742059e-01f, 7.160947323e-01f, 7.811764479e-01f, 1.046977043e+00f, 6.832172871e-01f,
+    3.793754578e-01f, 5.395220518e-01f, 4.965186119e-01f, 5.424836874e-01f, 6.832172871e-01f, 4.817197621e-01f,
+    4.823529124e-01f, 7.536764741e-01f, 4.823529124e-01f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    7.536764741e-01f, 1.339869261e+00f, 7.536764741e-01f, 4.823529124e-01f, 0.000000000e+00f, 1.098039269e+00f,
+    1.735163331e+00f, 3.632352829e+00f, 1.339869261e+00f, 3.224264622e+00f, 1.036470604e+01f, 2.470588207e+00f,
+    3.632352829e+00f, 1.315686321e+01f, 5.485294342e+00f, 1.122222233e+01f, 1.063602924e+01f, 1.036470604e+01f,
+    1.245411777e+01f, 1.267647076e+01f, 1.315686321e+01f, 5.485294342e+00f, 1.122222233e+01f, 3.224264622e+00f,
+    3.289215803e+00f, 1.245411777e+01f, 3.632352829e+00f, 2.437908649e+00f, 3.224264622e+00f, 1.580392122e+00f,
+    1.541549921e+00f, 3.289215803e+00f, 1.735163331e+00f, 1.371323586e+00f, 1.580392122e+00f, 9.526143670e-01f,
+    9.080882072e-01f, 1.541549921e+00f, 1.028186321e+00f, 8.776470423e-01f, 9.526143670e-01f, 6.413925290e-01f,
+    6.043573022e-01f, 9.080882072e-01f, 6.840335727e-01f, 6.094771624e-01f, 6.413925290e-01f, 4.629289508e-01f,
+    5.929411650e-01f, 9.264705777e-01f, 5.929411650e-01f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    9.264705777e-01f, 1.647058845e+00f, 9.264705777e-01f, 5.929411650e-01f, 0.000000000e+00f, 1.202614427e+00f,
+    2.079999924e+00f, 4.382352829e+00f, 1.647058845e+00f, 3.632352829e+00f, 1.141647053e+01f, 2.705882311e+00f,
+    4.382352829e+00f, 1.602614403e+01f, 6.411764622e+00f, 1.247058773e+01f, 1.175000000e+01f, 1.141647053e+01f,
+    1.525647068e+01f, 1.550000000e+01f, 1.602614403e+01f, 6.411764622e+00f, 1.247058773e+01f, 3.632352829e+00f,
+    4.006536007e+00f, 1.525647068e+01f, 4.382352829e+00f, 2.849673271e+00f, 3.632352829e+00f, 1.795555592e+00f,
+    1.867947221e+00f, 4.006536007e+00f, 2.079999924e+00f, 1.602941155e+00f, 1.795555592e+00f, 1.088235259e+00f,
+    1.095588207e+00f, 1.867947221e+00f, 1.227124214e+00f, 1.025882363e+00f, 1.088235259e+00f, 7.354621887e-01f,
+    7.265650034e-01f, 1.095588207e+00f, 8.138295412e-01f, 7.124183178e-01f, 7.354621887e-01f, 5.322712660e-01f,
+    5.999999642e-01f, 9.375000000e-01f, 5.999999642e-01f, 0.000000000e+00f, 0.000000000e+00f, 0.000000000e+00f,
+    9.375000000e-01f, 1.666666627e+00f, 9.375000000e-01f, 5.999999642e-01f, 0.000000000e+00f, 1.666666627e+00f,
+    2.266666651e+00f, 4.687500000e+00f, 1.666666627e+00f, 4.687500000e+00f, 1.560000038e+01f, 3.750000000e+00f,
+    4.687500000e+00f, 1.666666603e+01f, 7.500000000e+00f, 1.666666603e+01f, 1.593750000e+01f, 1.560000038e+01f,
+    1.560000038e+01f, 1.593750000e+01f, 1.666666603e+01f, 7.500000000e+00f, 1.666666603e+01f, 4.687500000e+00f,
+    4.166666508e+00f, 1.560000038e+01f, 4.687500000e+00f, 3.333333254e+00f, 4.687500000e+00f, 2.266666651e+00f,
+    1.972789049e+00f, 4.166666508e+00f, 2.266666651e+00f, 1.875000000e+00f, 2.266666651e+00f, 1.354166627e+00f,
+    1.171875000e+00f, 1.972789049e+00f, 1.354166627e+00f, 1.199999928e+00f, 1.354166627e+00f, 9.061224461e-01f,
+    7.851851583e-01f, 1.171875000e+00f, 9.061224461e-01f, 8.333333135e-01f, 9.061224461e-01f, 6.510416269e-01f,
+};
+
+static LightBake WORLD_LIGHT[2] = {
+    { .hash = 0xdec12b8b, .cells = 42, .layers = 3, .source = { -1, 38, 39, }, .data = WORLD_LIGHT_DATA + 0 },
+    { .hash = 0x632c74c6, .cells = 54, .layers = 1, .source = { -1, }, .data = WORLD_LIGHT_DATA + 504 },
+};
+
+#endif  /* WORLD_LIGHT_H */
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "core.h"
+#include "world.h"
+#include "light.h"
+
+#define BAKE_PATH "./assets/world_light.h"
+
+static float data[WORLD_COUNT * LIGHT_LAYERS_MAX * LIGHT_PLANES * WORLD_CELLS_MAX];
+
+LightSource source_of_cell(u16 info, size_t i, size_t cols)
+{
+    Color color = WHITE;
+    switch ((enum VisualColor) MASK_COLOR(info)) {
+        case VWHITE: { color = WHITE; } break;
+        case VBLUE: { color = C_BLUE; } break;
+        case VPINK: { color = C_PINK; } break;
+        case VBLACK: { color = BLACK; } break;
+    }
+    return (LightSource) {
+        .x = i % cols,
+        .y = i / cols,
+        .r = color.r / 255.f,
+        .g = color.g / 255.f,
+        .b = color.b / 255.f,
+        .strength = MASK_BRIGHTNESS(info) >> 12,
+    };
+}
+
+/**
+ * Bakes the light of every room in worlds. Layer 0 holds all static lights,
+ * the following layers one window each, so they can be switched and scaled
+ * by time of day at runtime
+ */
+int main(void)
+{
+    LightBake bakes[WORLD_COUNT];
+    size_t offsets[WORLD_COUNT];
+    size_t len = 0;
+
+    size_t w;
+    for (w = 0; w < WORLD_COUNT; ++w) {
+        size_t cols = worlds[w][0];
+        size_t rows = worlds[w][1];
+        size_t cells = cols * rows;
+        u16 *body = &worlds[w][2];
+
+        u8 heights[WORLD_CELLS_MAX];
+        size_t i;
+        for (i = 0; i < cells; ++i) {
+            heights[i] = MASK_HEIGHT(body[i]) >> 4;
+        }
+
+        LightGrid grid = {
+            .cols = cols,
+            .rows = rows,
+            .radius = LIGHT_RADIUS,
+            .heights = heights,
+            .falloff = light_falloff_init(cols, rows, LIGHT_RADIUS),
+        };
+        LightBake *bake = &bakes[w];
+        bake->hash = light_hash(worlds[w], cells + 2);
+        bake->cells = cells;
+        bake->layers = 1;
+        bake->source[0] = -1;
+
+        LightPlanes lp;
+        light_planes_init(&lp, cells);
+        LightSource srcs[WORLD_CELLS_MAX];
+        float scales[WORLD_CELLS_MAX];
+        size_t count = 0;
+        for (i = 0; i < cells; ++i) {
+            if (MASK_BRIGHTNESS(body[i]) == 0) continue;
+            if (MASK_PHYSICAL_T(body[i]) == PWINDOW) continue;
+            srcs[count] = source_of_cell(body[i], i, cols);
+            scales[count] = 1.f;
+            ++count;
+        }
+        light_compute(&lp, grid, srcs, scales, count, light_threads_default());
+
+        offsets[w] = len;
+        memcpy(&data[len], lp.r, LIGHT_PLANES * cells * sizeof *data);
+        len += LIGHT_PLANES * cells;
+
+        for (i = 0; i < cells; ++i) {
+            if (MASK_BRIGHTNESS(body[i]) == 0) continue;
+            if (MASK_PHYSICAL_T(body[i]) != PWINDOW) continue;
+            ASSERT(bake->layers < LIGHT_LAYERS_MAX, "Too many windows in world %zu", w);
+
+            light_planes_clear(&lp);
+            light_splat(&lp, grid, source_of_cell(body[i], i, cols), 1.f);
+            bake->source[bake->layers] = i;
+            bake->layers += 1;
+            memcpy(&data[len], lp.r, LIGHT_PLANES * cells * sizeof *data);
+            len += LIGHT_PLANES * cells;
+        }
+
+        light_planes_free(&lp);
+        free((float *) grid.falloff);
+        INFO("World %zu: %zu layers", w, bake->layers);
+    }
+
+    FILE *f = fopen(BAKE_PATH, "w");
+    ASSERT(f != NULL, "Could not open %s", BAKE_PATH);
+
+    fprintf(f, "// Generated by `make bake` from the rooms in src/world.h. Do not edit\n");
+    fprintf(f, "#ifndef WORLD_LIGHT_H\n#define WORLD_LIGHT_H\n\n");
+    fprintf(f, "#include \"../src/light.h\"\n\n");
+    fprintf(f, "static float WORLD_LIGHT_DATA[%zu] = {", len);
+    size_t i;
+    for (i = 0; i < len; ++i) {
+        fprintf(f, "%s%.9ef,", i % 6 == 0 ? "\n    " : " ", data[i]);
+    }
+    fprintf(f, "\n};\n\n");
+
+    fprintf(f, "static LightBake WORLD_LIGHT[%zu] = {\n", (size_t) WORLD_COUNT);
+    for (w = 0; w < WORLD_COUNT; ++w) {
+        LightBake *bake = &bakes[w];
+        fprintf(f, "    { .hash = 0x%08x, .cells = %zu, .layers = %zu, .source = {",
+                bake->hash, bake->cells, bake->layers);
+        size_t l;
+        for (l = 0; l < bake->layers; ++l) {
+            fprintf(f, " %d,", bake->source[l]);
+        }
+        fprintf(f, " }, .data = WORLD_LIGHT_DATA + %zu },\n", offsets[w]);
+    }
+    fprintf(f, "};\n\n#endif  /* WORLD_LIGHT_H */\n");
+    fclose(f);
+
+    INFO("Wrote %s", BAKE_PATH);
+    light_pool_free();
+    return 0;
+}
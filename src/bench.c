@@ -0,0 +1,187 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "core.h"
+#include "light.h"
+
+#define BENCH_LIGHTS 16
+#define BENCH_THREAD_LIGHTS 4096
+
+static u32 seed = 0x2f6b3a1d;
+
+u32 bench_rand(void)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Lighting as done before the light planes: blend() every light into the
+ * byte colors of every cell
+ */
+void light_blend_loop(Color *cells, LightGrid grid, LightSource *lights, size_t count)
+{
+    size_t i;
+    for (i = 0; i < grid.cols * grid.rows; ++i) {
+        cells[i] = BLACK;
+    }
+
+    size_t l;
+    for (l = 0; l < count; ++l) {
+        LightSource src = lights[l];
+        Color color = { src.r * 255.f, src.g * 255.f, src.b * 255.f, 255 };
+        size_t row, col;
+        for (row = 0; row < grid.rows; ++row) {
+            size_t dy = row > src.y ? row - src.y : src.y - row;
+            for (col = 0; col < grid.cols; ++col) {
+                size_t dx = col > src.x ? col - src.x : src.x - col;
+                i = row * grid.cols + col;
+                cells[i] = blend(cells[i], color, grid.falloff[dx + dy] * src.strength);
+            }
+        }
+    }
+}
+
+void light_planes_loop(Color *cells, LightPlanes *lp, LightGrid grid, LightSource *lights, size_t count)
+{
+    light_planes_clear(lp);
+
+    size_t l;
+    for (l = 0; l < count; ++l) {
+        light_splat(lp, grid, lights[l], 1.f);
+    }
+
+    size_t i;
+    for (i = 0; i < lp->len; ++i) {
+        cells[i] = light_resolve(lp, i);
+    }
+}
+
+void bench_room(size_t dim, int iterations)
+{
+    LightGrid grid = {
+        .cols = dim,
+        .rows = dim,
+        .radius = LIGHT_RADIUS,
+        .heights = NULL,
+        .falloff = light_falloff_init(dim, dim, LIGHT_RADIUS),
+    };
+
+    LightSource lights[BENCH_LIGHTS];
+    size_t l;
+    for (l = 0; l < BENCH_LIGHTS; ++l) {
+        lights[l] = (LightSource) {
+            .x = bench_rand() % dim,
+            .y = bench_rand() % dim,
+            .r = (bench_rand() % 256) / 255.f,
+            .g = (bench_rand() % 256) / 255.f,
+            .b = (bench_rand() % 256) / 255.f,
+            .strength = 1 + bench_rand() % 15,
+        };
+    }
+
+    Color *cells = malloc(dim * dim * sizeof *cells);
+    ASSERT(cells != NULL, "Malloc failed");
+    LightPlanes lp;
+    light_planes_init(&lp, dim * dim);
+
+    int i;
+    double start = bench_now();
+    for (i = 0; i < iterations; ++i) {
+        light_blend_loop(cells, grid, lights, BENCH_LIGHTS);
+    }
+    double blend_s = (bench_now() - start) / iterations;
+
+    start = bench_now();
+    for (i = 0; i < iterations; ++i) {
+        light_planes_loop(cells, &lp, grid, lights, BENCH_LIGHTS);
+    }
+    double planes_s = (bench_now() - start) / iterations;
+
+    printf("%3zux%-3zu %2d lights | blend %9.3f ms | planes (%s) %9.3f ms | %5.2fx\n",
+           dim, dim, BENCH_LIGHTS, blend_s * 1e3, LIGHT_SIMD, planes_s * 1e3, blend_s / planes_s);
+
+    light_planes_free(&lp);
+    free(cells);
+    free((float *) grid.falloff);
+}
+
+/**
+ * light_compute on a dim x dim room from 1 thread up to every core. Each run
+ * must match the single threaded planes bit for bit
+ */
+void bench_threads(size_t dim, int iterations)
+{
+    LightGrid grid = {
+        .cols = dim,
+        .rows = dim,
+        .radius = LIGHT_RADIUS,
+        .heights = NULL,
+        .falloff = light_falloff_init(dim, dim, LIGHT_RADIUS),
+    };
+
+    LightSource *lights = malloc(BENCH_THREAD_LIGHTS * sizeof *lights);
+    float *scales = malloc(BENCH_THREAD_LIGHTS * sizeof *scales);
+    ASSERT(lights != NULL && scales != NULL, "Malloc failed");
+    size_t l;
+    for (l = 0; l < BENCH_THREAD_LIGHTS; ++l) {
+        lights[l] = (LightSource) {
+            .x = bench_rand() % dim,
+            .y = bench_rand() % dim,
+            .r = (bench_rand() % 256) / 255.f,
+            .g = (bench_rand() % 256) / 255.f,
+            .b = (bench_rand() % 256) / 255.f,
+            .strength = 1 + bench_rand() % 15,
+        };
+        scales[l] = 1.f;
+    }
+
+    LightPlanes reference, lp;
+    light_planes_init(&reference, dim * dim);
+    light_planes_init(&lp, dim * dim);
+    light_compute(&reference, grid, lights, scales, BENCH_THREAD_LIGHTS, 1);
+
+    double single_s = 0.f;
+    size_t max = light_threads_default();
+    size_t threads;
+    for (threads = 1; threads <= max; threads = threads < max && threads * 2 > max ? max : threads * 2) {
+        int i;
+        double start = bench_now();
+        for (i = 0; i < iterations; ++i) {
+            light_planes_clear(&lp);
+            light_compute(&lp, grid, lights, scales, BENCH_THREAD_LIGHTS, threads);
+        }
+        double s = (bench_now() - start) / iterations;
+        if (threads == 1) single_s = s;
+
+        bool same = memcmp(reference.r, lp.r, LIGHT_PLANES * lp.len * sizeof *lp.r) == 0;
+        printf("%3zux%-3zu %4d lights | %2zu threads %9.3f ms | %5.2fx | %s\n",
+               dim, dim, BENCH_THREAD_LIGHTS, threads, s * 1e3, single_s / s, same ? "identical" : "MISMATCH");
+        ASSERT(same, "Threaded lighting differs from single threaded");
+        if (threads == max) break;
+    }
+
+    light_planes_free(&reference);
+    light_planes_free(&lp);
+    free(scales);
+    free(lights);
+    free((float *) grid.falloff);
+}
+
+int main(void)
+{
+    bench_room(64, 200);
+    bench_room(256, 20);
+    bench_threads(512, 10);
+    light_pool_free();
+    return 0;
+}
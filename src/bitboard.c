@@ -0,0 +1,209 @@
+#include "bitboard.h"
+
+#include <string.h>
+
+#include "puzzle.h"
+
+/**
+ * As MASK_HEIGHT and MASK_TYPE in puzzle.c
+ */
+#define CELL_HEIGHT(a) ((a) & 0b11)
+#define CELL_TYPE(a) ((a) & 0b1100)
+
+/**
+ * Cells exactly h high in row y
+ */
+u64 bitboard_height_eq(const BitboardMap *map, int h, size_t y)
+{
+    return map->level[h][y] & (h == 0 ? ~0ull : ~map->level[h - 1][y]);
+}
+
+/**
+ * Highest cell a clone of height h may step onto
+ */
+int bitboard_reach(int h, bool roll)
+{
+    return MIN(h + (roll ? 1 : 0), BITBOARD_HEIGHTS - 1);
+}
+
+u64 bitboard_reverse(u64 v)
+{
+    v = ((v >> 1) & 0x5555555555555555ull) | ((v & 0x5555555555555555ull) << 1);
+    v = ((v >> 2) & 0x3333333333333333ull) | ((v & 0x3333333333333333ull) << 2);
+    v = ((v >> 4) & 0x0f0f0f0f0f0f0f0full) | ((v & 0x0f0f0f0f0f0f0f0full) << 4);
+    v = ((v >> 8) & 0x00ff00ff00ff00ffull) | ((v & 0x00ff00ff00ff00ffull) << 8);
+    v = ((v >> 16) & 0x0000ffff0000ffffull) | ((v & 0x0000ffff0000ffffull) << 16);
+    return (v >> 32) | (v << 32);
+}
+
+/**
+ * Moves bit x to 2 * line - x - 1. Bits landing left of 0 are dropped
+ */
+u64 bitboard_reflect(u64 v, int line)
+{
+    if (line <= 0) return 0;
+    v = bitboard_reverse(v);  /* x to 63 - x */
+    return 2 * line <= 64 ? v >> (64 - 2 * line) : v << (2 * line - 64);
+}
+
+void bitboard_load(BitboardMap *map, Bitboard *b, const unsigned char *bytes)
+{
+    memset(map, 0, sizeof *map);
+    memset(b, 0, sizeof *b);
+    map->cols = bytes[0];
+    map->rows = bytes[1];
+    ASSERT(map->cols <= BITBOARD_MAX && map->rows <= BITBOARD_MAX, "Puzzle is %zux%zu, larger than a bitboard",
+            map->cols, map->rows);
+    map->full = map->cols == 64 ? ~0ull : (1ull << map->cols) - 1;
+
+    const unsigned char *body = &bytes[3];
+    size_t x, y;
+    for (y = 0; y < map->rows; ++y) {
+        for (x = 0; x < map->cols; ++x) {
+            unsigned char info = body[y * map->cols + x];
+            u64 bit = 1ull << x;
+            int h;
+            for (h = CELL_HEIGHT(info); h < BITBOARD_HEIGHTS; ++h) {
+                map->level[h][y] |= bit;
+            }
+            if (CELL_TYPE(info) == G) map->goals[y] |= bit;
+            if (CELL_TYPE(info) == P) {
+                b->clones[y] |= bit;
+                b->fresh[y] |= bit;
+            }
+        }
+    }
+}
+
+/**
+ * Clones in row y whose height lets them enter row dst, one column to the
+ * right if shift > 0 or to the left if shift < 0. Ignores other clones
+ */
+u64 bitboard_can_enter(const BitboardMap *map, const Bitboard *b, size_t y, size_t dst, int shift, bool roll)
+{
+    u64 full = map->full;
+    u64 can = 0;
+    int h;
+    for (h = 0; h < BITBOARD_HEIGHTS; ++h) {
+        u64 clones = b->clones[y] & ~b->fresh[y] & bitboard_height_eq(map, h, y);
+        u64 enter = map->level[bitboard_reach(h, roll)][dst];
+        can |= clones & (shift > 0 ? enter >> 1 : shift < 0 ? enter << 1 : enter);
+    }
+    can |= b->fresh[y] & (shift > 0 ? full >> 1 : shift < 0 ? full << 1 : full);
+    return can & full;
+}
+
+/**
+ * Steps every clone one cell in dir, as puzzle_move
+ * Returns the amount of clones that moved
+ */
+size_t bitboard_move(const BitboardMap *map, Bitboard *b, Direction dir, bool roll)
+{
+    size_t moved = 0;
+    switch (dir) {
+        case UP:
+        case DOWN: {
+            // Front row first, so rows enter cells the row ahead just left
+            size_t i;
+            for (i = 1; i < map->rows; ++i) {
+                size_t y = dir == UP ? i : map->rows - 1 - i;
+                size_t dst = dir == UP ? y - 1 : y + 1;
+                u64 m = bitboard_can_enter(map, b, y, dst, 0, roll) & ~b->clones[dst];
+                b->clones[dst] |= m;
+                b->clones[y] &= ~m;
+                b->fresh[y] &= ~m;
+                moved += __builtin_popcountll(m);
+            }
+        } break;
+        case LEFT:
+        case RIGHT: {
+            int shift = dir == RIGHT ? 1 : -1;
+            size_t y;
+            for (y = 0; y < map->rows; ++y) {
+                u64 can = bitboard_can_enter(map, b, y, y, shift, roll);
+                u64 free = ~b->clones[y] & map->full;
+                // A clone moves if the cell ahead is free or its clone moves
+                u64 m = 0;
+                u64 prev;
+                do {
+                    prev = m;
+                    m = can & (shift > 0 ? (free | m) >> 1 : (free | m) << 1);
+                } while (m != prev);
+                b->clones[y] = (b->clones[y] & ~m) | (shift > 0 ? m << 1 : m >> 1);
+                b->fresh[y] &= ~m;
+                moved += __builtin_popcountll(m);
+            }
+        } break;
+        default: {
+            ASSERT(0, "Unreachable");
+        } break;
+    }
+    return moved;
+}
+
+/**
+ * Clones every clone over grid line line, as mirror_over_line. The line
+ * lies above row line for MIRROR_UP and MIRROR_DOWN, else left of column
+ * line
+ * Returns the amount of clones added
+ */
+size_t bitboard_mirror(const BitboardMap *map, Bitboard *b, int line, int options)
+{
+    size_t added = 0;
+    if (options & MIRROR_UP || options & MIRROR_DOWN) {
+        // Rows from the side given by options, each onto its reflection
+        size_t y;
+        for (y = 0; y < map->rows; ++y) {
+            int dst = 2 * line - (int) y - 1;
+            if ((dst >= line && options & MIRROR_UP) || (dst < line && options & MIRROR_DOWN)) continue;
+            if (dst < 0 || dst >= (int) map->rows) continue;
+
+            u64 add = b->fresh[y];
+            int h;
+            for (h = 0; h < BITBOARD_HEIGHTS; ++h) {
+                u64 clones = b->clones[y] & ~b->fresh[y] & bitboard_height_eq(map, h, y);
+                add |= clones & map->level[h][dst];
+            }
+            add &= ~b->clones[dst];
+            b->clones[dst] |= add;
+            added += __builtin_popcountll(add);
+        }
+    } else if (options & MIRROR_LEFT || options & MIRROR_RIGHT) {
+        // Each row reversed around the line
+        if (line <= 0) return 0;
+        u64 left = line >= 64 ? ~0ull : (1ull << line) - 1;
+        u64 from = options & MIRROR_LEFT ? ~left : left;
+        size_t y;
+        for (y = 0; y < map->rows; ++y) {
+            u64 add = bitboard_reflect(b->fresh[y] & from, line);
+            int h;
+            for (h = 0; h < BITBOARD_HEIGHTS; ++h) {
+                u64 clones = b->clones[y] & ~b->fresh[y] & bitboard_height_eq(map, h, y) & from;
+                add |= bitboard_reflect(clones, line) & map->level[h][y];
+            }
+            add &= ~b->clones[y] & map->full;
+            b->clones[y] |= add;
+            added += __builtin_popcountll(add);
+        }
+    }
+    return added;
+}
+
+bool bitboard_is_finished(const BitboardMap *map, const Bitboard *b)
+{
+    size_t y;
+    for (y = 0; y < map->rows; ++y) {
+        if (map->goals[y] & ~b->clones[y]) return false;
+    }
+    return true;
+}
+
+size_t bitboard_clones(const BitboardMap *map, const Bitboard *b)
+{
+    size_t count = 0;
+    size_t y;
+    for (y = 0; y < map->rows; ++y) {
+        count += __builtin_popcountll(b->clones[y]);
+    }
+    return count;
+}
@@ -0,0 +1,44 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "core.h"
+
+/**
+ * Puzzle states as bit-rows
+ *
+ * Bit x of row y stands for the cell at x, y. A BitboardMap holds what never
+ * changes after load: the goals and, for every height h, the cells at most h
+ * high. A Bitboard holds the clones. A clone stands as high as the cell
+ * under it, except for the ones placed by the puzzle, which climb anything
+ * until they first move; those are also set in fresh.
+ *
+ * Moves are shifts masked by the cells each height may enter, swept front
+ * row first as update_puzzle does. Mirrors OR reversed rows, or rows in
+ * reversed order, into the clones. No raylib calls, so search tools can
+ * use it headless.
+ */
+
+#define BITBOARD_MAX 64  /* Most rows or columns of a board */
+#define BITBOARD_HEIGHTS 4
+
+typedef struct BitboardMap {
+    size_t cols;
+    size_t rows;
+    u64 full;  /* Every column of a row */
+    u64 level[BITBOARD_HEIGHTS][BITBOARD_MAX];  /* Cells at most h high */
+    u64 goals[BITBOARD_MAX];
+} BitboardMap;
+
+typedef struct Bitboard {
+    u64 clones[BITBOARD_MAX];
+    u64 fresh[BITBOARD_MAX];  /* Clones not moved since load */
+} Bitboard;
+
+int bitboard_reach(int h, bool roll);
+void bitboard_load(BitboardMap *map, Bitboard *b, const unsigned char *bytes);
+size_t bitboard_move(const BitboardMap *map, Bitboard *b, Direction dir, bool roll);
+size_t bitboard_mirror(const BitboardMap *map, Bitboard *b, int line, int options);
+bool bitboard_is_finished(const BitboardMap *map, const Bitboard *b);
+size_t bitboard_clones(const BitboardMap *map, const Bitboard *b);
+
+#endif  /* BITBOARD_H */
@@ -0,0 +1,183 @@
+#include "canvas.h"
+
+static struct {
+    bool enabled;
+    RenderTexture2D target;  /* id 0 until the first enabled frame */
+    int scale;
+    int scale_max;
+    int misses;  /* Frames in a row over budget */
+    int hits;  /* Frames in a row within budget */
+    int raise_after;  /* Doubled whenever a raise has to be taken back */
+    bool raised;  /* Last change was a raise */
+    CanvasStats stats;
+} canvas = { 0 };
+
+void canvas_set_enabled(bool enabled)
+{
+    if (!enabled && canvas.target.id != 0) {
+        UnloadRenderTexture(canvas.target);
+        canvas.target.id = 0;
+    }
+    canvas.enabled = enabled;
+    canvas.scale = 0;
+    canvas.scale_max = 0;
+}
+
+bool canvas_enabled(void)
+{
+    return canvas.enabled;
+}
+
+int canvas_width(void)
+{
+    return canvas.scale == 0 ? GetScreenWidth() : CANVAS_BASE_WIDTH * canvas.scale;
+}
+
+int canvas_height(void)
+{
+    return canvas.scale == 0 ? GetScreenHeight() : CANVAS_BASE_HEIGHT * canvas.scale;
+}
+
+/**
+ * Next divisor of scale_max from scale in direction dir, or scale if there
+ * is none
+ */
+int canvas_scale_step(int scale, int dir)
+{
+    int s;
+    for (s = scale + dir; s >= 1 && s <= canvas.scale_max; s += dir) {
+        if (canvas.scale_max % s == 0) return s;
+    }
+    return scale;
+}
+
+void canvas_govern(float frame_time)
+{
+    if (frame_time > CANVAS_FRAME_BUDGET * CANVAS_MISS_FACTOR) {
+        canvas.hits = 0;
+        canvas.misses += 1;
+        if (canvas.misses < CANVAS_MISS_FRAMES) return;
+
+        canvas.misses = 0;
+        int scale = canvas_scale_step(canvas.scale, -1);
+        if (scale == canvas.scale) return;
+        if (canvas.raised) canvas.raise_after *= 2;
+        canvas.scale = scale;
+        canvas.raised = false;
+        canvas.stats.drops += 1;
+        INFO("Canvas scale lowered to %d", scale);
+    } else {
+        canvas.misses = 0;
+        canvas.hits += 1;
+        if (canvas.hits < canvas.raise_after) return;
+
+        canvas.hits = 0;
+        int scale = canvas_scale_step(canvas.scale, 1);
+        if (scale == canvas.scale) return;
+        canvas.scale = scale;
+        canvas.raised = true;
+        canvas.stats.raises += 1;
+        INFO("Canvas scale raised to %d", scale);
+    }
+}
+
+/**
+ * Top left corner of the upscaled canvas in the window
+ */
+Vector2 canvas_offset(void)
+{
+    return (Vector2) {
+        .x = (GetScreenWidth() - CANVAS_BASE_WIDTH * canvas.scale_max) / 2,
+        .y = (GetScreenHeight() - CANVAS_BASE_HEIGHT * canvas.scale_max) / 2,
+    };
+}
+
+/**
+ * Picks the internal scale for this frame from the window size and the
+ * time the last frame took, 0 if it is not known. Call before update and
+ * render, as both work in canvas space
+ */
+void canvas_update(float frame_time)
+{
+    if (!canvas.enabled) {
+        SetMouseOffset(0, 0);
+        SetMouseScale(1.f, 1.f);
+        return;
+    }
+
+    int scale_max = MAX(MIN(GetScreenWidth() / CANVAS_BASE_WIDTH, GetScreenHeight() / CANVAS_BASE_HEIGHT), 1);
+    if (scale_max != canvas.scale_max) {
+        canvas.scale_max = scale_max;
+        canvas.scale = scale_max;
+        canvas.misses = 0;
+        canvas.hits = 0;
+        canvas.raise_after = CANVAS_RAISE_FRAMES;
+        canvas.raised = false;
+    } else if (frame_time > 0.f) {
+        canvas_govern(frame_time);
+    }
+
+    int width = canvas_width();
+    int height = canvas_height();
+    if (canvas.target.id != 0 && (canvas.target.texture.width != width || canvas.target.texture.height != height)) {
+        UnloadRenderTexture(canvas.target);
+        canvas.target.id = 0;
+    }
+    if (canvas.target.id == 0) {
+        canvas.target = LoadRenderTexture(width, height);
+        SetTextureFilter(canvas.target.texture, TEXTURE_FILTER_POINT);
+    }
+
+    int upscale = canvas.scale_max / canvas.scale;
+    Vector2 offset = canvas_offset();
+    SetMouseOffset(-offset.x, -offset.y);
+    SetMouseScale(1.f / upscale, 1.f / upscale);
+}
+
+/**
+ * Binds and clears the canvas. Render textures drawn into while recording
+ * would unbind it again, so only call this right before submitting
+ */
+void canvas_begin(void)
+{
+    if (canvas.enabled) {
+        BeginTextureMode(canvas.target);
+    }
+    ClearBackground(BLACK);
+}
+
+/**
+ * Blits the canvas to the window
+ */
+void canvas_end(void)
+{
+    if (!canvas.enabled) return;
+    EndTextureMode();
+
+    ClearBackground(BLACK);
+    int upscale = canvas.scale_max / canvas.scale;
+    Vector2 offset = canvas_offset();
+    // Render textures are stored upside down
+    Rectangle src = { 0.f, 0.f, canvas.target.texture.width, -canvas.target.texture.height };
+    Rectangle dest = {
+        .x = offset.x,
+        .y = offset.y,
+        .width = canvas.target.texture.width * upscale,
+        .height = canvas.target.texture.height * upscale,
+    };
+    DrawTexturePro(canvas.target.texture, src, dest, (Vector2) { 0.f, 0.f }, 0.f, WHITE);
+}
+
+void canvas_free(void)
+{
+    canvas_set_enabled(false);
+}
+
+CanvasStats canvas_stats(void)
+{
+    CanvasStats stats = canvas.stats;
+    stats.scale = canvas.scale;
+    stats.scale_max = canvas.scale_max;
+    stats.upscale = canvas.scale == 0 ? 1 : canvas.scale_max / canvas.scale;
+    return stats;
+}
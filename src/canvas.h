@@ -0,0 +1,50 @@
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <raylib.h>
+#include "core.h"
+
+/**
+ * Internal render target
+ *
+ * While enabled, the frame is drawn into a render texture of
+ * CANVAS_BASE_WIDTH x CANVAS_BASE_HEIGHT times the internal scale, and
+ * blitted to the window at an integer upscale, letterboxed. Render code
+ * lays out against canvas_width and canvas_height instead of the screen,
+ * and the mouse is mapped into canvas space.
+ *
+ * The internal scale starts at the largest one that fits the window. When
+ * CANVAS_MISS_FRAMES frames in a row miss CANVAS_FRAME_BUDGET it drops to the
+ * next smaller divisor of that, so the picture keeps its size on screen.
+ * After CANVAS_RAISE_FRAMES frames within budget the next larger one is
+ * tried again.
+ *
+ * While disabled the canvas is the window.
+ */
+
+#define CANVAS_BASE_WIDTH 400
+#define CANVAS_BASE_HEIGHT 300
+#define CANVAS_FRAME_BUDGET (1.f / 60.f)
+#define CANVAS_MISS_FACTOR 1.25f  /* Frames slower than the budget times this miss it */
+#define CANVAS_MISS_FRAMES 30
+#define CANVAS_RAISE_FRAMES 600
+
+typedef struct CanvasStats {
+    int scale;  /* Internal scale, 0 while disabled */
+    int scale_max;  /* Largest scale fitting the window */
+    int upscale;  /* Window pixels per canvas pixel */
+    size_t drops;  /* Times the governor lowered the scale */
+    size_t raises;
+} CanvasStats;
+
+void canvas_set_enabled(bool enabled);
+bool canvas_enabled(void);
+int canvas_width(void);
+int canvas_height(void);
+void canvas_update(float frame_time);
+void canvas_begin(void);
+void canvas_end(void);
+void canvas_free(void);
+CanvasStats canvas_stats(void);
+
+#endif  /* CANVAS_H */
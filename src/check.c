@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "bitboard.h"
+#define CASE_IMPLEMENTATION
+#include "case.h"
+#include "core.h"
+#include "puzzle.h"
+
+#define CHECK_WALKS 200
+#define CHECK_STEPS 60
+
+static u32 seed = 0x5eed1e55;
+
+u32 check_rand(void)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+/**
+ * Compares every cell of the engine and the bitboard. Fresh clones carry
+ * the player byte as height in the engine, so they stand at 4 or more
+ */
+bool check_same(Puzzle *p, const BitboardMap *map, const Bitboard *b, const unsigned char *bytes)
+{
+    size_t x, y;
+    for (y = 0; y < map->rows; ++y) {
+        for (x = 0; x < map->cols; ++x) {
+            int height = puzzle_player_height_at(p, x, y);
+            bool clone = (b->clones[y] >> x) & 1;
+            bool fresh = (b->fresh[y] >> x) & 1;
+            if (height == -1 && !clone) continue;
+
+            int cell_height = bytes[3 + y * map->cols + x] & 0b11;
+            if (height == -1 || !clone || (fresh ? height < BITBOARD_HEIGHTS : height != cell_height)) {
+                ERROR("At %zu, %zu: engine height %d, bitboard %s", x, y, height,
+                        clone ? fresh ? "fresh clone" : "clone" : "empty");
+                return false;
+            }
+        }
+    }
+    return puzzle_is_finished(p) == bitboard_is_finished(map, b);
+}
+
+/**
+ * Random walks of moves, rolls and mirrors on both representations. Pain
+ * and energy have no cap, so nobody faints
+ */
+bool check_puzzle(const char *name, unsigned char *bytes)
+{
+    BitboardMap map;
+    Bitboard start;
+    bitboard_load(&map, &start, bytes);
+    size_t lines = (map.rows - 1) + (map.cols - 1);
+    Direction dirs[] = { UP, DOWN, LEFT, RIGHT };
+
+    size_t steps = 0;
+    size_t max_clones = 0;
+    int w;
+    for (w = 0; w < CHECK_WALKS; ++w) {
+        Puzzle *p = load_puzzle(bytes);
+        Bitboard b = start;
+        PlayerState pstate = { .pain_max = 1e9f, .energy = 1e9f };
+        float pain = pstate.pain;
+        float energy = pstate.energy;
+
+        int s;
+        for (s = 0; s < CHECK_STEPS; ++s) {
+            char action[64];
+            u32 r = check_rand();
+            if (lines > 0 && r % 3 == 0) {
+                int button = (r / 3) % lines;
+                bool row = button < (int) map.rows - 1;
+                int line = row ? button + 1 : button - ((int) map.rows - 1) + 1;
+                int options = row ? (r & 64 ? MIRROR_UP : MIRROR_DOWN) : (r & 64 ? MIRROR_LEFT : MIRROR_RIGHT);
+                snprintf(action, sizeof action, "mirror %s %d %s", row ? "row" : "column", line,
+                        options & (MIRROR_UP | MIRROR_LEFT) ? "back" : "forth");
+
+                mirror_over_line(p, button, options, &pstate);
+                size_t added = bitboard_mirror(&map, &b, line, options);
+                size_t i;
+                for (i = 0; i < added; ++i) pain += PENALTY_PAIN;
+            } else {
+                Direction dir = dirs[(r / 3) % 4];
+                bool roll = r & 64;
+                snprintf(action, sizeof action, "%s %c", roll ? "roll" : "move", dir);
+
+                puzzle_move(p, dir, roll, &pstate);
+                size_t moved = bitboard_move(&map, &b, dir, roll);
+                if (roll && moved > 0) energy -= PENALTY_ENERGY;
+            }
+            steps += 1;
+            max_clones = MAX(max_clones, bitboard_clones(&map, &b));
+
+            if (!check_same(p, &map, &b, bytes) || pain != pstate.pain || energy != pstate.energy) {
+                ERROR("%s: walk %d step %d (%s) differs", name, w, s, action);
+                free_puzzle(p);
+                return false;
+            }
+        }
+        free_puzzle(p);
+    }
+    printf("%-10s %2zux%-2zu | %6zu steps | up to %3zu clones | same\n",
+           name, map.cols, map.rows, steps, max_clones);
+    return true;
+}
+
+int main(void)
+{
+    bool ok = true;
+    char name[16];
+    size_t i;
+    for (i = 0; i < FUN_PUZZLES; ++i) {
+        snprintf(name, sizeof name, "fun %zu", i);
+        ok &= check_puzzle(name, puzzle_fun_array[i]);
+    }
+    for (i = 0; i < TRAIN_PUZZLES; ++i) {
+        snprintf(name, sizeof name, "train %zu", i);
+        ok &= check_puzzle(name, puzzle_train_array[i]);
+    }
+    ok &= check_puzzle("boss", puzzle_boss);
+    return ok ? 0 : 1;
+}
@@ -1,4 +1,7 @@
 #include "core.h"
+#include "draw.h"
+#include "font.h"
+#include "canvas.h"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
@@ -16,56 +19,125 @@ Color blend(Color main, Color blend, float intencity)
     };
 }
 
+static TextSurface hud_energy = { 0 };
+static TextSurface hud_pain = { 0 };
+static TextSurface hud_date = { 0 };
+static long hud_clock = -1;  /* hud_clock_of of the text in hud_date */
+
+void text_surface_set(TextSurface *ts, const char *text, int size)
+{
+    if (ts->size == size && strncmp(ts->text, text, sizeof ts->text) == 0) return;
+    snprintf(ts->text, sizeof ts->text, "%s", text);
+    ts->size = size;
+    ts->dirty = true;
+}
+
+/**
+ * Blits the text at pos, drawing it first if needed. Text is drawn white
+ * with the UI font and tinted on blit, as DrawText does
+ */
+void text_surface_draw(TextSurface *ts, Vector2 pos, Color color)
+{
+    int screen_width = canvas_width();
+    int screen_height = canvas_height();
+    if (ts->dirty || ts->target.id == 0 || ts->screen_width != screen_width || ts->screen_height != screen_height) {
+        int size = MAX(ts->size, 10);  /* As DrawText */
+        Vector2 dim = text_measure(ts->text, size, size / 10);
+        int width = MAX((int) ceilf(dim.x), 1);
+        int height = MAX((int) ceilf(dim.y), 1);
+        if (ts->target.id != 0 && (ts->target.texture.width != width || ts->target.texture.height != height)) {
+            UnloadRenderTexture(ts->target);
+            ts->target.id = 0;
+        }
+        if (ts->target.id == 0) {
+            ts->target = LoadRenderTexture(width, height);
+        }
+
+        bool recording = draw_suspend();
+        BeginTextureMode(ts->target);
+        ClearBackground(BLANK);
+        text_draw(ts->text, (Vector2) { 0.f, 0.f }, size, size / 10, WHITE);
+        EndTextureMode();
+        draw_resume(recording);
+
+        ts->screen_width = screen_width;
+        ts->screen_height = screen_height;
+        ts->dirty = false;
+    }
+
+    // Render textures are stored upside down
+    Rectangle src = { 0.f, 0.f, ts->target.texture.width, -ts->target.texture.height };
+    draw_texture_rec(ts->target.texture, src, pos, color);
+}
+
+void text_surface_free(TextSurface *ts)
+{
+    if (ts->target.id != 0) UnloadRenderTexture(ts->target);
+    ts->target.id = 0;
+}
+
+void free_hud(void)
+{
+    text_surface_free(&hud_energy);
+    text_surface_free(&hud_pain);
+    text_surface_free(&hud_date);
+}
 
 void render_hud_rhs(PlayerState pstate, float offx, Texture2D atlas)
 {
     (void) atlas;
 
-    float s_width = GetScreenWidth();
-    float s_height = GetScreenHeight();
+    float s_width = canvas_width();
+    float s_height = canvas_height();
     float padx = (s_width - offx) / 10.f;
     float x = offx;
     float width = s_width - x;
     float ysec = s_height * (1.f / 9.f);
 
-    DrawRectangleLinesEx((Rectangle) {
+    draw_set_layer(DRAW_LAYER_UI);
+    draw_rectangle_lines_ex((Rectangle) {
         .width = width - 2.f * padx,
         .height = 3 * (pstate.energy_max / pstate.energy_lim) * ysec,
         .x = x + padx,
         .y = ysec + 3 * (1.f - (pstate.energy_max / pstate.energy_lim)) * ysec,
     }, 2.f, C_BLUE);
 
-    DrawRectangleRec((Rectangle) {
+    draw_rectangle_rec((Rectangle) {
         .width = width - 2.f * padx,
         .height = 3 * (pstate.energy / pstate.energy_lim) * ysec,
         .x = x + padx,
         .y = ysec + 3 * (1.f - (pstate.energy / pstate.energy_lim)) * ysec,
     }, C_BLUE);
 
-    DrawRectangleLinesEx((Rectangle) {
+    draw_rectangle_lines_ex((Rectangle) {
         .width = width - 2.f * padx,
         .height = 3 * ysec,
         .x = x + padx,
         .y = ysec,
     }, 2.f, WHITE);
 
-    DrawText("Energy", x + padx, ysec * 0.5f, 24.f, C_BLUE);
+    draw_set_layer(DRAW_LAYER_HUD_TEXT);
+    text_surface_set(&hud_energy, "Energy", 24);
+    text_surface_draw(&hud_energy, (Vector2) { (int) (x + padx), (int) (ysec * 0.5f) }, C_BLUE);
 
-    DrawRectangleRec((Rectangle) {
+    draw_set_layer(DRAW_LAYER_UI);
+    draw_rectangle_rec((Rectangle) {
         .width = width - 2.f * padx,
         .height = 3 * (pstate.pain / pstate.pain_max) * ysec,
         .x = x + padx,
         .y = 5 * ysec + 3 * (1.f - (pstate.pain / pstate.pain_max)) * ysec,
     }, C_PINK);
 
-    DrawRectangleLinesEx((Rectangle) {
+    draw_rectangle_lines_ex((Rectangle) {
         .width = width - 2.f * padx,
         .height = 3 * ysec,
         .x = x + padx,
         .y = 5 * ysec,
     }, 2.f, WHITE);
 
-    DrawText("Pain", x + padx, 4 * ysec + ysec * 0.5f, 24.f, C_PINK);
+    draw_set_layer(DRAW_LAYER_HUD_TEXT);
+    text_surface_set(&hud_pain, "Pain", 24);
+    text_surface_draw(&hud_pain, (Vector2) { (int) (x + padx), (int) (4 * ysec + ysec * 0.5f) }, C_PINK);
 }
 
 void format_date(PlayerState pstate, char *dest, size_t sz)
@@ -95,28 +167,45 @@ void format_time(PlayerState pstate, char *dest, size_t sz)
     snprintf(dest, sz, "%02.0f:%02.0f", hour, minute);
 }
 
+/**
+ * Day, hour and minute as shown by format_date and format_time
+ */
+long hud_clock_of(PlayerState pstate)
+{
+    float day = floorf(pstate.time);
+    float t = (pstate.time - day) * 24.f;
+    float hour = floorf(t);
+    return ((long) day * 24 + (long) hour) * 60 + lrintf((t - hour) * 59.f);
+}
+
 void render_hud_lhs(PlayerState pstate, float offx, Texture2D atlas)
 {
     (void) atlas;
     (void) offx;
 
-    float s_width = GetScreenWidth();
-    float s_height = GetScreenHeight();
+    float s_width = canvas_width();
+    float s_height = canvas_height();
     float padx = (s_width - offx) / 10.f;
     float x = 0;
     // float width = s_width - offx;
     float ysec = s_height * (1.f / 9.f);
 
 
-    char day[38];
-    format_date(pstate, day, sizeof day);
-    size_t len = strlen(day);
-    day[len + 0] = '\n';
-    day[len + 1] = '\n';
-    format_time(pstate, (char *) (day + len + 2), 6);
-    // INFO("%s", day);
-    // INFO("%s", day + len + 1);
-    DrawText(day, x + padx, ysec * 0.5f, 19.f, WHITE);
+    long clock = hud_clock_of(pstate);
+    if (clock != hud_clock) {
+        char day[38];
+        format_date(pstate, day, sizeof day);
+        size_t len = strlen(day);
+        day[len + 0] = '\n';
+        day[len + 1] = '\n';
+        format_time(pstate, (char *) (day + len + 2), 6);
+        // INFO("%s", day);
+        // INFO("%s", day + len + 1);
+        text_surface_set(&hud_date, day, 19);
+        hud_clock = clock;
+    }
+    draw_set_layer(DRAW_LAYER_HUD_TEXT);
+    text_surface_draw(&hud_date, (Vector2) { (int) (x + padx), (int) (ysec * 0.5f) }, WHITE);
 }
 
 void render_player(Vector2 vs_pos, Vector2 dim, PlayerState pstate, Texture2D player_atlas, Color color)
@@ -148,10 +237,12 @@ void render_player(Vector2 vs_pos, Vector2 dim, PlayerState pstate, Texture2D pl
 
     Color fade = Fade(pstate.ani_color, pstate.ani_time_remaining / pstate.ani_time_max);
 
-    DrawRectangleV(vs_pos, dim, color);
-    DrawRectangleV(vs_pos, dim, fade);
+    draw_set_layer(DRAW_LAYER_ACTOR_BG);
+    draw_rectangle_v(vs_pos, dim, color);
+    draw_rectangle_v(vs_pos, dim, fade);
 
-    DrawTexturePro(player_atlas, src, dest, (Vector2) { 0.f, 0.f }, 0, color);
+    draw_set_layer(DRAW_LAYER_ACTOR);
+    draw_texture_pro(player_atlas, src, dest, (Vector2) { 0.f, 0.f }, 0, color);
 }
 
 void player_start_animation(PlayerState *pstate, Color color)
@@ -161,9 +252,17 @@ void player_start_animation(PlayerState *pstate, Color color)
     pstate->ani_time_remaining = 0.5f;
 }
 
+/**
+ * GetFrameTime, clamped to FRAME_TIME_MAX
+ */
+float frame_time(void)
+{
+    return MIN(GetFrameTime(), FRAME_TIME_MAX);
+}
+
 void update_pstate(PlayerState *pstate)
 {
-    pstate->ani_time_remaining -= GetFrameTime();
+    pstate->ani_time_remaining -= frame_time();
     if (pstate->ani_time_remaining < 0.f) {
         pstate->ani_time_remaining = 0.f;
     }
@@ -236,3 +335,88 @@ int new_face_id(int face_id, Direction dir)
     ASSERT(0, "Unreachable");
 }
 
+void height_edges_push(HeightEdges *he, HeightEdge run)
+{
+    if (run.len > 0 && run.diff > 0) {
+        he->runs[he->count] = run;
+        he->count += 1;
+    }
+}
+
+/**
+ * Merges neighbouring borders with equal height difference into maximal runs
+ */
+HeightEdges height_edges_init(const u8 *heights, size_t cols, size_t rows)
+{
+    HeightEdges he = { 0 };
+    size_t max = MAX(2 * cols * rows, 1);
+    he.runs = malloc(max * sizeof *he.runs);
+    he.quads = malloc(max * sizeof *he.quads);
+    ASSERT(he.runs != NULL && he.quads != NULL, "Malloc failed");
+    he.cell_width = -1.f;  /* Forces the first layout */
+
+    size_t row, col;
+    for (row = 1; row < rows; ++row) {
+        HeightEdge run = { 0 };
+        for (col = 0; col < cols; ++col) {
+            u8 a = heights[(row - 1) * cols + col];
+            u8 b = heights[row * cols + col];
+            u8 diff = a > b ? a - b : b - a;
+            if (run.len > 0 && run.diff == diff) {
+                run.len += 1;
+                continue;
+            }
+            height_edges_push(&he, run);
+            run = (HeightEdge) { .x = col, .y = row, .len = 1, .diff = diff, .vertical = false };
+        }
+        height_edges_push(&he, run);
+    }
+
+    for (col = 1; col < cols; ++col) {
+        HeightEdge run = { 0 };
+        for (row = 0; row < rows; ++row) {
+            u8 a = heights[row * cols + col - 1];
+            u8 b = heights[row * cols + col];
+            u8 diff = a > b ? a - b : b - a;
+            if (run.len > 0 && run.diff == diff) {
+                run.len += 1;
+                continue;
+            }
+            height_edges_push(&he, run);
+            run = (HeightEdge) { .x = col, .y = row, .len = 1, .diff = diff, .vertical = true };
+        }
+        height_edges_push(&he, run);
+    }
+    return he;
+}
+
+/**
+ * Places the runs for a board at origin. Lines are thickness pixels wide
+ * per height step and centered on the border
+ */
+void height_edges_layout(HeightEdges *he, Vector2 origin, float cell_width, float thickness)
+{
+    if (he->origin.x == origin.x && he->origin.y == origin.y && he->cell_width == cell_width) {
+        return;
+    }
+    he->origin = origin;
+    he->cell_width = cell_width;
+
+    size_t i;
+    for (i = 0; i < he->count; ++i) {
+        HeightEdge run = he->runs[i];
+        float across = run.diff * thickness;
+        float x = origin.x + run.x * cell_width;
+        float y = origin.y + run.y * cell_width;
+        he->quads[i] = run.vertical
+            ? (Rectangle) { x - across / 2.f, y, across, run.len * cell_width }
+            : (Rectangle) { x, y - across / 2.f, run.len * cell_width, across };
+    }
+}
+
+void height_edges_free(HeightEdges *he)
+{
+    free(he->runs);
+    free(he->quads);
+    he->count = 0;
+}
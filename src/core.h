@@ -19,6 +19,7 @@
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
 #include <stdint.h>
+typedef uint64_t u64;
 typedef uint32_t u32;
 typedef uint16_t u16;
 typedef uint8_t u8;
@@ -37,15 +38,16 @@ typedef uint8_t u8;
 #define ENERGY_MAX_LIM 1.f
 #define ENERGY_MAX_INC ((ENERGY_MAX_LIM - ENERGY_MAX_INIT) * (1.f / TRAIN_PUZZLES))
 
+#define PAIN_INIT 0.2f
+#define PAIN_MAX 1.f
+
 #define PENALTY_ENERGY_TIME 0.02f
 #define PENALTY_PAIN_TIME 0.02f
 #define PENALTY_PAIN 0.05f
 #define PENALTY_ENERGY 0.025f
 #define SLEEP_SPEED 0.04f
+#define FRAME_TIME_MAX (1.f / 20.f)  /* Frames after an idle wait would otherwise skip animations */
 
-#define FONT_SIZE_BIG (GetScreenWidth() / 18.f)
-#define FONT_SIZE_MID (GetScreenWidth() / 30.f)
-#define FONT_SIZE_SMALL (GetScreenWidth() / 45.f)
 #define LINE_SPACE 1.35f
 
 typedef enum {
@@ -91,17 +93,65 @@ typedef struct {
     float ani_time_remaining;
 } PlayerState;
 
+#define TEXT_SURFACE_MAX 64
+
+/**
+ * Text drawn once into a render texture with the UI font. Redrawn only
+ * when the text, font size or screen size changes
+ */
+typedef struct TextSurface {
+    RenderTexture2D target;  /* id 0 until first drawn */
+    char text[TEXT_SURFACE_MAX];
+    int size;
+    int screen_width;
+    int screen_height;
+    bool dirty;
+} TextSurface;
+
+/**
+ * Run of cell borders with the same height difference, in cells. Horizontal
+ * runs lie on the top border of row y starting at column x, vertical runs
+ * on the left border of column x starting at row y.
+ */
+typedef struct HeightEdge {
+    u16 x;
+    u16 y;
+    u16 len;
+    u8 diff;
+    bool vertical;
+} HeightEdge;
+
+/**
+ * Height lines of a board, extracted once at load. quads holds the runs in
+ * view space and is only rebuilt when the layout changes
+ */
+typedef struct HeightEdges {
+    HeightEdge *runs;
+    Rectangle *quads;
+    size_t count;
+    Vector2 origin;
+    float cell_width;
+} HeightEdges;
+
 Color blend(Color main, Color blend, float intencity);
 void render_hud_rhs(PlayerState pstate, float offx, Texture2D atlas);
 void render_hud_lhs(PlayerState pstate, float offx, Texture2D atlas);
 void format_time(PlayerState pstate, char *dest, size_t sz);
+void text_surface_set(TextSurface *ts, const char *text, int size);
+void text_surface_draw(TextSurface *ts, Vector2 pos, Color color);
+void text_surface_free(TextSurface *ts);
+void free_hud(void);
 void render_player(Vector2 vs_pos, Vector2 dim, PlayerState pstate, Texture2D player_atlas, Color color);
 void player_start_animation(PlayerState *pstate, Color color);
+float frame_time(void);
 void update_pstate(PlayerState *pstate);
 void apply_energy_loss(PlayerState *pstate);
 void apply_pain(PlayerState *pstate);
 bool should_faint(PlayerState pstate);
 int new_face_id(int face_id, Direction dir);
+HeightEdges height_edges_init(const u8 *heights, size_t cols, size_t rows);
+void height_edges_layout(HeightEdges *he, Vector2 origin, float cell_width, float thickness);
+void height_edges_free(HeightEdges *he);
 
 #ifdef TEST
 #define TEST_ASSERT(statement) test_assert(statement, #statement)
@@ -0,0 +1,337 @@
+#include "draw.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "shader.h"
+
+#define DRAW_CMDS_INIT 1024
+#define DRAW_TEXT_INIT 4096
+
+typedef enum {
+    DRAW_TEXTURE,
+    DRAW_RECT,
+    DRAW_RECT_LINES,
+    DRAW_LINE,
+    DRAW_TEXT,
+} DrawKind;
+
+typedef struct DrawCmd {
+    DrawKind kind;
+    DrawLayer layer;
+    int blend;  /* BlendMode, BLEND_ALPHA by default */
+    Shader shader;  /* id 0 for the default shader */
+    Texture2D texture;  /* Sort key only, except for DRAW_TEXTURE */
+    size_t seq;
+    Rectangle src;
+    Rectangle dest;  /* Line: start in x, y and end in width, height */
+    Vector2 origin;
+    float scalar;  /* Rotation, thickness or font size */
+    float spacing;
+    Color color;
+    Font font;
+    size_t text;  /* Offset into the text buffer */
+} DrawCmd;
+
+static struct {
+    DrawCmd *cmds;
+    size_t len;
+    size_t cap;
+    char *text;
+    size_t text_len;
+    size_t text_cap;
+
+    bool recording;
+    DrawLayer layer;
+    int blend;
+    Shader shader;
+    DrawStats stats;
+} draw = { 0 };
+
+void draw_frame_begin(void)
+{
+    if (draw.cmds == NULL) {
+        draw.cap = DRAW_CMDS_INIT;
+        draw.cmds = malloc(draw.cap * sizeof *draw.cmds);
+        draw.text_cap = DRAW_TEXT_INIT;
+        draw.text = malloc(draw.text_cap);
+        ASSERT(draw.cmds != NULL && draw.text != NULL, "Malloc failed");
+    }
+    draw.len = 0;
+    draw.text_len = 0;
+    draw.layer = DRAW_LAYER_BOARD;
+    draw.blend = BLEND_ALPHA;
+    draw.shader = (Shader) { 0 };
+    draw.recording = true;
+}
+
+/**
+ * Stops recording, e.g. while drawing into a render texture
+ * Returns whether it was recording, to be passed to draw_resume
+ */
+bool draw_suspend(void)
+{
+    bool recording = draw.recording;
+    draw.recording = false;
+    return recording;
+}
+
+void draw_resume(bool recording)
+{
+    draw.recording = recording;
+}
+
+DrawStats draw_stats(void)
+{
+    return draw.stats;
+}
+
+void draw_set_layer(DrawLayer layer)
+{
+    draw.layer = layer;
+}
+
+void draw_begin_shader(Shader shader)
+{
+    if (draw.recording) {
+        draw.shader = shader;
+    } else {
+        BeginShaderMode(shader);
+        shader_bind_textures(shader);
+    }
+}
+
+void draw_end_shader(void)
+{
+    if (draw.recording) {
+        draw.shader = (Shader) { 0 };
+    } else {
+        EndShaderMode();
+    }
+}
+
+void draw_begin_blend(int mode)
+{
+    if (draw.recording) {
+        draw.blend = mode;
+    } else {
+        BeginBlendMode(mode);
+    }
+}
+
+void draw_end_blend(void)
+{
+    if (draw.recording) {
+        draw.blend = BLEND_ALPHA;
+    } else {
+        EndBlendMode();
+    }
+}
+
+void draw_exec(DrawCmd *cmd)
+{
+    switch (cmd->kind) {
+        case DRAW_TEXTURE: {
+            DrawTexturePro(cmd->texture, cmd->src, cmd->dest, cmd->origin, cmd->scalar, cmd->color);
+        } break;
+        case DRAW_RECT: { DrawRectangleRec(cmd->dest, cmd->color); } break;
+        case DRAW_RECT_LINES: { DrawRectangleLinesEx(cmd->dest, cmd->scalar, cmd->color); } break;
+        case DRAW_LINE: {
+            Vector2 start = { cmd->dest.x, cmd->dest.y };
+            Vector2 end = { cmd->dest.width, cmd->dest.height };
+            DrawLineEx(start, end, cmd->scalar, cmd->color);
+        } break;
+        case DRAW_TEXT: {
+            Vector2 pos = { cmd->dest.x, cmd->dest.y };
+            DrawTextEx(cmd->font, &draw.text[cmd->text], pos, cmd->scalar, cmd->spacing, cmd->color);
+        } break;
+    }
+}
+
+/**
+ * Records cmd with the current layer, blend mode and shader, or draws it
+ * right away
+ */
+void draw_push(DrawCmd cmd)
+{
+    cmd.layer = draw.layer;
+    cmd.blend = draw.blend;
+    cmd.shader = draw.shader;
+    if (!draw.recording) {
+        draw_exec(&cmd);
+        return;
+    }
+
+    if (draw.len >= draw.cap) {
+        draw.cap *= 2;
+        draw.cmds = realloc(draw.cmds, draw.cap * sizeof *draw.cmds);
+        ASSERT(draw.cmds != NULL, "Realloc failed");
+    }
+    cmd.seq = draw.len;
+    draw.cmds[draw.len] = cmd;
+    draw.len += 1;
+}
+
+/**
+ * Copies text into the frame, as callers may pass TextFormat buffers
+ */
+size_t draw_push_text(const char *text)
+{
+    size_t len = strlen(text) + 1;
+    while (draw.text_len + len > draw.text_cap) {
+        draw.text_cap *= 2;
+        draw.text = realloc(draw.text, draw.text_cap);
+        ASSERT(draw.text != NULL, "Realloc failed");
+    }
+    size_t off = draw.text_len;
+    memcpy(&draw.text[off], text, len);
+    draw.text_len += len;
+    return off;
+}
+
+int draw_cmd_cmp(const void *a, const void *b)
+{
+    const DrawCmd *x = a;
+    const DrawCmd *y = b;
+    if (x->layer != y->layer) return x->layer < y->layer ? -1 : 1;
+    if (x->blend != y->blend) return x->blend < y->blend ? -1 : 1;
+    if (x->shader.id != y->shader.id) return x->shader.id < y->shader.id ? -1 : 1;
+    if (x->texture.id != y->texture.id) return x->texture.id < y->texture.id ? -1 : 1;
+    if (x->seq != y->seq) return x->seq < y->seq ? -1 : 1;
+    return 0;
+}
+
+void draw_frame_end(void)
+{
+    DrawStats stats = { 0 };
+    stats.commands = draw.len;
+
+    size_t i;
+    for (i = 1; i < draw.len; ++i) {
+        if (draw.cmds[i].texture.id != draw.cmds[i - 1].texture.id) stats.texture_switches_unsorted += 1;
+    }
+
+    qsort(draw.cmds, draw.len, sizeof *draw.cmds, draw_cmd_cmp);
+
+    int blend = BLEND_ALPHA;
+    unsigned int shader = 0;
+    for (i = 0; i < draw.len; ++i) {
+        DrawCmd *cmd = &draw.cmds[i];
+        bool new_blend = cmd->blend != blend;
+        if (new_blend) {
+            if (cmd->blend == BLEND_ALPHA) {
+                EndBlendMode();
+            } else {
+                BeginBlendMode(cmd->blend);
+            }
+            blend = cmd->blend;
+        }
+        bool new_shader = cmd->shader.id != shader;
+        bool new_texture = i > 0 && cmd->texture.id != draw.cmds[i - 1].texture.id;
+        if (new_shader) {
+            if (cmd->shader.id == 0) {
+                EndShaderMode();
+            } else {
+                BeginShaderMode(cmd->shader);
+                shader_bind_textures(cmd->shader);
+            }
+            shader = cmd->shader.id;
+        }
+        if (new_texture) stats.texture_switches += 1;
+        if (i == 0 || new_blend || new_shader || new_texture) stats.batches += 1;
+        draw_exec(cmd);
+    }
+    if (shader != 0) EndShaderMode();
+    if (blend != BLEND_ALPHA) EndBlendMode();
+
+    draw.stats = stats;
+    draw.recording = false;
+}
+
+void draw_texture_pro(Texture2D texture, Rectangle src, Rectangle dest, Vector2 origin, float rotation, Color tint)
+{
+    draw_push((DrawCmd) {
+        .kind = DRAW_TEXTURE,
+        .texture = texture,
+        .src = src,
+        .dest = dest,
+        .origin = origin,
+        .scalar = rotation,
+        .color = tint,
+    });
+}
+
+/**
+ * As DrawTextureRec. A negative src height flips, e.g. for render textures
+ */
+void draw_texture_rec(Texture2D texture, Rectangle src, Vector2 pos, Color tint)
+{
+    Rectangle dest = { pos.x, pos.y, src.width < 0 ? -src.width : src.width, src.height < 0 ? -src.height : src.height };
+    draw_texture_pro(texture, src, dest, (Vector2) { 0.f, 0.f }, 0.f, tint);
+}
+
+void draw_rectangle_rec(Rectangle rec, Color color)
+{
+    draw_push((DrawCmd) {
+        .kind = DRAW_RECT,
+        .texture = GetShapesTexture(),
+        .dest = rec,
+        .color = color,
+    });
+}
+
+void draw_rectangle_v(Vector2 pos, Vector2 size, Color color)
+{
+    draw_rectangle_rec((Rectangle) { pos.x, pos.y, size.x, size.y }, color);
+}
+
+void draw_rectangle_lines_ex(Rectangle rec, float thick, Color color)
+{
+    draw_push((DrawCmd) {
+        .kind = DRAW_RECT_LINES,
+        .texture = GetShapesTexture(),
+        .dest = rec,
+        .scalar = thick,
+        .color = color,
+    });
+}
+
+void draw_line_ex(Vector2 start, Vector2 end, float thick, Color color)
+{
+    draw_push((DrawCmd) {
+        .kind = DRAW_LINE,
+        .texture = GetShapesTexture(),
+        .dest = (Rectangle) { start.x, start.y, end.x, end.y },
+        .scalar = thick,
+        .color = color,
+    });
+}
+
+void draw_text_ex(Font font, const char *text, Vector2 pos, float size, float spacing, Color tint)
+{
+    DrawCmd cmd = {
+        .kind = DRAW_TEXT,
+        .texture = font.texture,
+        .dest = (Rectangle) { pos.x, pos.y, 0.f, 0.f },
+        .scalar = size,
+        .spacing = spacing,
+        .color = tint,
+        .font = font,
+    };
+    if (draw.recording) {
+        cmd.text = draw_push_text(text);
+        draw_push(cmd);
+    } else {
+        DrawTextEx(font, text, pos, size, spacing, tint);
+    }
+}
+
+/**
+ * As DrawText, with the default font
+ */
+void draw_text(const char *text, int x, int y, int size, Color color)
+{
+    int min_size = 10;  /* Size of the default font */
+    size = MAX(size, min_size);
+    draw_text_ex(GetFontDefault(), text, (Vector2) { x, y }, size, size / min_size, color);
+}
@@ -0,0 +1,66 @@
+#ifndef DRAW_H
+#define DRAW_H
+
+#include <raylib.h>
+#include "core.h"
+
+/**
+ * Frame command buffer
+ *
+ * Between draw_frame_begin and draw_frame_end the draw_ functions record
+ * commands instead of drawing. draw_frame_end sorts them by layer, blend
+ * mode, shader and texture and submits them, so raylib flushes its batch as few times as
+ * possible. Record order is kept for commands with equal keys, but within a
+ * layer overlapping draws with different textures may be reordered.
+ *
+ * Shader uniforms are read when the commands are submitted, so set the
+ * uniforms of a shader once per frame.
+ *
+ * Outside a frame, or while suspended, the draw_ functions draw directly.
+ */
+
+typedef enum {
+    DRAW_LAYER_BACKDROP,  /* Frozen scene under modal states */
+    DRAW_LAYER_BOARD,  /* World and puzzle cells */
+    DRAW_LAYER_GRID,  /* Puzzle grid and border */
+    DRAW_LAYER_EDGES,  /* Height lines */
+    DRAW_LAYER_VIGNETTE,  /* Light falloff multiplied over the board */
+    DRAW_LAYER_ACTOR_BG,  /* Backdrop and animation of players */
+    DRAW_LAYER_ACTOR,
+    DRAW_LAYER_SELECTION,
+    DRAW_LAYER_UI,  /* Buttons and hud */
+    DRAW_LAYER_HUD_TEXT,  /* Under the overlay, as the hud is drawn before it */
+    DRAW_LAYER_OVERLAY,  /* Sleep and win panels */
+    DRAW_LAYER_TEXT,
+    DRAW_LAYER_DEBUG,
+} DrawLayer;
+
+typedef struct DrawStats {
+    size_t commands;
+    size_t batches;  /* Runs of equal blend mode, shader and texture, each one draw call */
+    size_t texture_switches;
+    size_t texture_switches_unsorted;  /* Had the commands been submitted in record order */
+} DrawStats;
+
+void draw_frame_begin(void);
+void draw_frame_end(void);
+bool draw_suspend(void);
+void draw_resume(bool recording);
+DrawStats draw_stats(void);
+
+void draw_set_layer(DrawLayer layer);
+void draw_begin_blend(int mode);
+void draw_end_blend(void);
+void draw_begin_shader(Shader shader);
+void draw_end_shader(void);
+
+void draw_texture_pro(Texture2D texture, Rectangle src, Rectangle dest, Vector2 origin, float rotation, Color tint);
+void draw_texture_rec(Texture2D texture, Rectangle src, Vector2 pos, Color tint);
+void draw_rectangle_rec(Rectangle rec, Color color);
+void draw_rectangle_v(Vector2 pos, Vector2 size, Color color);
+void draw_rectangle_lines_ex(Rectangle rec, float thick, Color color);
+void draw_line_ex(Vector2 start, Vector2 end, float thick, Color color);
+void draw_text_ex(Font font, const char *text, Vector2 pos, float size, float spacing, Color tint);
+void draw_text(const char *text, int x, int y, int size, Color color);
+
+#endif  /* DRAW_H */
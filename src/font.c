@@ -0,0 +1,258 @@
+#include "font.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "draw.h"
+#include "shader.h"
+
+#define FONT_EDT_INF 1e20f
+
+static char *sdf_fs =
+	"#version 100\n"
+	"#extension GL_OES_standard_derivatives : enable\n"
+	"\n"
+	"precision mediump float;\n"
+	"\n"
+	"varying vec2 fragTexCoord;\n"
+	"varying vec4 fragColor;\n"
+	"\n"
+	"uniform sampler2D texture0;\n"
+	"uniform vec4 colDiffuse;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"    float dist = texture2D(texture0, fragTexCoord).r - 0.5;\n"
+	"    float width = length(vec2(dFdx(dist), dFdy(dist)));\n"
+	"    float alpha = smoothstep(-width, width, dist);\n"
+	"    gl_FragColor = vec4(fragColor.rgb, fragColor.a * alpha) * colDiffuse;\n"
+	"}\n";
+
+typedef struct MeasureSlot {
+    bool used;
+    u32 hash;
+    float size;
+    float spacing;
+    char text[FONT_MEASURE_TEXT];
+    Vector2 dim;
+} MeasureSlot;
+
+static Font sdf_font = { 0 };
+static ShaderProgram *sdf_shader = NULL;
+static MeasureSlot measure_cache[FONT_MEASURE_SLOTS] = { 0 };
+static size_t measure_hits = 0;
+static size_t measure_misses = 0;
+
+/**
+ * Squared distance transform of one row or column (Felzenszwalb and
+ * Huttenlocher). f holds 0 on features and FONT_EDT_INF elsewhere
+ */
+void edt_1d(const float *f, float *d, int *v, float *z, int n)
+{
+    int k = 0;
+    v[0] = 0;
+    z[0] = -FONT_EDT_INF;
+    z[1] = FONT_EDT_INF;
+
+    int q;
+    for (q = 1; q < n; ++q) {
+        float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.f * q - 2.f * v[k]);
+        while (s <= z[k]) {
+            --k;
+            s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.f * q - 2.f * v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = FONT_EDT_INF;
+    }
+
+    k = 0;
+    for (q = 0; q < n; ++q) {
+        while (z[k + 1] < q) ++k;
+        d[q] = (float) (q - v[k]) * (q - v[k]) + f[v[k]];
+    }
+}
+
+/**
+ * Euclidean distance from every texel to the nearest texel where
+ * is_feature[i] == feature
+ */
+void edt_2d(const bool *is_feature, bool feature, float *out, int width, int height)
+{
+    int n = MAX(width, height);
+    float *f = calloc(n, sizeof *f);
+    float *d = malloc(n * sizeof *d);
+    float *z = malloc((n + 1) * sizeof *z);
+    int *v = malloc(n * sizeof *v);
+    ASSERT(f != NULL && d != NULL && z != NULL && v != NULL, "Malloc failed");
+
+    int x, y;
+    for (x = 0; x < width; ++x) {
+        for (y = 0; y < height; ++y) {
+            f[y] = is_feature[y * width + x] == feature ? 0.f : FONT_EDT_INF;
+        }
+        edt_1d(f, d, v, z, height);
+        for (y = 0; y < height; ++y) {
+            out[y * width + x] = d[y];
+        }
+    }
+    for (y = 0; y < height; ++y) {
+        memcpy(f, &out[y * width], width * sizeof *f);
+        edt_1d(f, d, v, z, width);
+        for (x = 0; x < width; ++x) {
+            out[y * width + x] = sqrtf(d[x]);
+        }
+    }
+
+    free(f);
+    free(d);
+    free(z);
+    free(v);
+}
+
+/**
+ * Builds the distance field atlas from the default font. Call after InitWindow
+ */
+void font_init(void)
+{
+    Font def = GetFontDefault();
+    Image src = LoadImageFromTexture(def.texture);
+    ImageFormat(&src, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    Color *pixels = src.data;
+
+    int width = src.width * FONT_SDF_SCALE;
+    int height = src.height * FONT_SDF_SCALE;
+    size_t texels = (size_t) width * height;
+    bool *ink = malloc(texels * sizeof *ink);
+    float *outside = malloc(texels * sizeof *outside);
+    float *inside = malloc(texels * sizeof *inside);
+    unsigned char *sdf = malloc(texels);
+    ASSERT(ink != NULL && outside != NULL && inside != NULL && sdf != NULL, "Malloc failed");
+
+    int x, y;
+    for (y = 0; y < height; ++y) {
+        for (x = 0; x < width; ++x) {
+            Color c = pixels[(y / FONT_SDF_SCALE) * src.width + x / FONT_SDF_SCALE];
+            ink[y * width + x] = c.a > 127;
+        }
+    }
+    edt_2d(ink, true, outside, width, height);
+    edt_2d(ink, false, inside, width, height);
+
+    size_t i;
+    for (i = 0; i < texels; ++i) {
+        float value = 0.5f + (inside[i] - outside[i]) / (2.f * FONT_SDF_SPREAD);
+        sdf[i] = (unsigned char) (MIN(MAX(value, 0.f), 1.f) * 255.f + 0.5f);
+    }
+
+    Image atlas = {
+        .data = sdf,
+        .width = width,
+        .height = height,
+        .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE,
+        .mipmaps = 1,
+    };
+    sdf_font.texture = LoadTextureFromImage(atlas);
+    SetTextureFilter(sdf_font.texture, TEXTURE_FILTER_BILINEAR);
+
+    sdf_font.baseSize = def.baseSize * FONT_SDF_SCALE;
+    sdf_font.glyphCount = def.glyphCount;
+    sdf_font.glyphPadding = def.glyphPadding * FONT_SDF_SCALE;
+    sdf_font.recs = malloc(def.glyphCount * sizeof *sdf_font.recs);
+    sdf_font.glyphs = malloc(def.glyphCount * sizeof *sdf_font.glyphs);
+    ASSERT(sdf_font.recs != NULL && sdf_font.glyphs != NULL, "Malloc failed");
+    int g;
+    for (g = 0; g < def.glyphCount; ++g) {
+        Rectangle rec = def.recs[g];
+        sdf_font.recs[g] = (Rectangle) {
+            rec.x * FONT_SDF_SCALE, rec.y * FONT_SDF_SCALE,
+            rec.width * FONT_SDF_SCALE, rec.height * FONT_SDF_SCALE,
+        };
+        GlyphInfo glyph = def.glyphs[g];
+        glyph.offsetX *= FONT_SDF_SCALE;
+        glyph.offsetY *= FONT_SDF_SCALE;
+        glyph.advanceX *= FONT_SDF_SCALE;
+        glyph.image = (Image) { 0 };
+        sdf_font.glyphs[g] = glyph;
+    }
+
+    sdf_shader = shader_load("sdf", shader_vs, sdf_fs, NULL, 0);
+
+    free(ink);
+    free(outside);
+    free(inside);
+    free(sdf);
+    UnloadImage(src);
+    INFO("SDF font atlas %dx%d", width, height);
+}
+
+void font_free(void)
+{
+    if (sdf_font.texture.id == 0) return;
+    UnloadFont(sdf_font);
+    sdf_font = (Font) { 0 };
+}
+
+u32 text_hash(const char *text, float size, float spacing)
+{
+    u32 hash = 2166136261u;
+    for (; *text != '\0'; ++text) {
+        hash = (hash ^ (unsigned char) *text) * 16777619u;
+    }
+    u32 bits[2];
+    memcpy(&bits[0], &size, sizeof size);
+    memcpy(&bits[1], &spacing, sizeof spacing);
+    hash = (hash ^ bits[0]) * 16777619u;
+    hash = (hash ^ bits[1]) * 16777619u;
+    return hash;
+}
+
+/**
+ * MeasureTextEx with the UI font, cached per text, size and spacing
+ */
+Vector2 text_measure(const char *text, float size, float spacing)
+{
+    Font font = sdf_font.texture.id != 0 ? sdf_font : GetFontDefault();
+    if (strlen(text) >= FONT_MEASURE_TEXT) {
+        measure_misses += 1;
+        return MeasureTextEx(font, text, size, spacing);
+    }
+
+    u32 hash = text_hash(text, size, spacing);
+    MeasureSlot *slot = &measure_cache[hash % FONT_MEASURE_SLOTS];
+    if (slot->used && slot->hash == hash && slot->size == size && slot->spacing == spacing
+        && strcmp(slot->text, text) == 0) {
+        measure_hits += 1;
+        return slot->dim;
+    }
+
+    measure_misses += 1;
+    slot->used = true;
+    slot->hash = hash;
+    slot->size = size;
+    slot->spacing = spacing;
+    strcpy(slot->text, text);
+    slot->dim = MeasureTextEx(font, text, size, spacing);
+    return slot->dim;
+}
+
+/**
+ * DrawTextEx with the UI font. Falls back to the default font before font_init
+ */
+void text_draw(const char *text, Vector2 pos, float size, float spacing, Color color)
+{
+    if (sdf_font.texture.id == 0) {
+        draw_text_ex(GetFontDefault(), text, pos, size, spacing, color);
+        return;
+    }
+    draw_begin_shader(sdf_shader->shader);
+    draw_text_ex(sdf_font, text, pos, size, spacing, color);
+    draw_end_shader();
+}
+
+void text_measure_stats(size_t *hits, size_t *misses)
+{
+    *hits = measure_hits;
+    *misses = measure_misses;
+}
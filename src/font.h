@@ -0,0 +1,26 @@
+#ifndef FONT_H
+#define FONT_H
+
+#include <raylib.h>
+#include "core.h"
+
+/**
+ * UI text
+ *
+ * font_init turns the default font into a signed distance field atlas, drawn
+ * with a small shader so text stays sharp at any size. Measurements of the
+ * same text, size and spacing are cached.
+ */
+
+#define FONT_SDF_SCALE 4  /* Atlas texels per pixel of the default font */
+#define FONT_SDF_SPREAD 4.f  /* Distance in atlas texels spanning [0.5, 1] */
+#define FONT_MEASURE_SLOTS 128
+#define FONT_MEASURE_TEXT 64  /* Longer text is measured every time */
+
+void font_init(void);
+void font_free(void);
+Vector2 text_measure(const char *text, float size, float spacing);
+void text_draw(const char *text, Vector2 pos, float size, float spacing, Color color);
+void text_measure_stats(size_t *hits, size_t *misses);
+
+#endif  /* FONT_H */
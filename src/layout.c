@@ -0,0 +1,31 @@
+#include "layout.h"
+
+#include "canvas.h"
+
+static Layout layout = { 0 };
+
+void layout_update(void)
+{
+    int width = canvas_width();
+    int height = canvas_height();
+    if (layout.version != 0 && layout.width == width && layout.height == height) return;
+
+    layout = (Layout) {
+        .width = width,
+        .height = height,
+        .version = layout.version + 1,
+        .font_big = width / 18.f,
+        .font_mid = width / 30.f,
+        .font_small = width / 45.f,
+    };
+}
+
+Layout layout_get(void)
+{
+    return layout;
+}
+
+size_t layout_version(void)
+{
+    return layout.version;
+}
@@ -0,0 +1,34 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <raylib.h>
+#include "core.h"
+
+/**
+ * View space layout
+ *
+ * layout_update recomputes the canvas wide sizes once at the start of a
+ * frame, and bumps the version when the canvas size changed. Boards keep
+ * the version they were laid out for and lay themselves out again only
+ * when it differs, before update reads their rectangles. So update and
+ * render of a frame see the same layout.
+ */
+
+typedef struct Layout {
+    int width;  /* Canvas size it was computed for */
+    int height;
+    size_t version;  /* Never 0, so boards can use 0 for not laid out */
+    float font_big;
+    float font_mid;
+    float font_small;
+} Layout;
+
+#define FONT_SIZE_BIG (layout_get().font_big)
+#define FONT_SIZE_MID (layout_get().font_mid)
+#define FONT_SIZE_SMALL (layout_get().font_small)
+
+void layout_update(void);
+Layout layout_get(void);
+size_t layout_version(void);
+
+#endif  /* LAYOUT_H */
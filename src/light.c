@@ -0,0 +1,471 @@
+#define _POSIX_C_SOURCE 200809L
+#include "light.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef PLATFORM_WEB
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+// Builds without -mavx2 still take the AVX2 path on CPUs that have it
+#if defined(__SSE2__) && !defined(__AVX2__) && defined(__x86_64__) && defined(__GNUC__)
+    #define LIGHT_AVX2_DISPATCH
+#endif
+
+#if defined(__AVX2__) || defined(LIGHT_AVX2_DISPATCH)
+    #include <immintrin.h>
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+    #include <wasm_simd128.h>
+#endif
+
+/**
+ * Inverse square falloff for every manhattan distance in a cols x rows room.
+ * Distances past radius get no light
+ */
+float *light_falloff_init(size_t cols, size_t rows, size_t radius)
+{
+    size_t len = cols + rows - 1;
+    float *falloff = malloc(len * sizeof *falloff);
+    ASSERT(falloff != NULL, "Malloc failed");
+
+    falloff[0] = 1.f;
+    size_t i;
+    for (i = 1; i < len; ++i) {
+        falloff[i] = i > radius ? 0.f : 1.f / (float) (i * i);
+    }
+    return falloff;
+}
+
+/**
+ * Cells a source at x, y can reach
+ */
+LightRect light_rect(LightGrid grid, size_t x, size_t y)
+{
+    return (LightRect) {
+        .x0 = x > grid.radius ? x - grid.radius : 0,
+        .y0 = y > grid.radius ? y - grid.radius : 0,
+        .x1 = MIN(x + grid.radius + 1, grid.cols),
+        .y1 = MIN(y + grid.radius + 1, grid.rows),
+    };
+}
+
+/**
+ * Walks the line from the source to the cell. Cells in between that are at
+ * least LIGHT_OCCLUDER_HEIGHT tall block the light
+ */
+bool light_is_visible(LightGrid grid, LightSource src, size_t x, size_t y)
+{
+    if (grid.heights == NULL) return true;
+
+    int x0 = src.x;
+    int y0 = src.y;
+    int x1 = x;
+    int y1 = y;
+    int dx = abs(x1 - x0);
+    int dy = -abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1;
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    if (x0 == x1 && y0 == y1) return true;
+
+    for (;;) {
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x0 += sx; }
+        if (e2 <= dx) { err += dx; y0 += sy; }
+        if (x0 == x1 && y0 == y1) return true;
+        if (grid.heights[y0 * grid.cols + x0] >= LIGHT_OCCLUDER_HEIGHT) return false;
+    }
+}
+
+/**
+ * @return k of source at cell. 0 if it is occluded
+ */
+float light_weight(LightGrid grid, LightSource src, size_t x, size_t y)
+{
+    size_t dx = x > src.x ? x - src.x : src.x - x;
+    size_t dy = y > src.y ? y - src.y : src.y - y;
+    if (dx + dy > grid.radius) return 0.f;
+    if (dx + dy > 1 && !light_is_visible(grid, src, x, y)) return 0.f;
+    return grid.falloff[dx + dy] * src.strength;
+}
+
+void light_planes_init(LightPlanes *lp, size_t len)
+{
+    float *mem = calloc(LIGHT_PLANES * len, sizeof *mem);
+    ASSERT(mem != NULL, "Calloc failed");
+    lp->r = mem;
+    lp->g = mem + len;
+    lp->b = mem + 2 * len;
+    lp->w = mem + 3 * len;
+    lp->len = len;
+}
+
+void light_planes_clear(LightPlanes *lp)
+{
+    memset(lp->r, 0, LIGHT_PLANES * lp->len * sizeof *lp->r);
+}
+
+void light_planes_free(LightPlanes *lp)
+{
+    free(lp->r);
+    memset(lp, 0, sizeof *lp);
+}
+
+#ifdef LIGHT_AVX2_DISPATCH
+/**
+ * The __AVX2__ loop of light_axpy, compiled for AVX2 alone. Returns the
+ * floats done. The products and sums are the SSE2 ones, so are the bits
+ */
+__attribute__((target("avx2")))
+static size_t light_axpy_avx2(float *dst, const float *src, float scale, size_t n)
+{
+    size_t i = 0;
+    __m256 vs = _mm256_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_loadu_ps(dst + i);
+        d = _mm256_add_ps(d, _mm256_mul_ps(vs, _mm256_loadu_ps(src + i)));
+        _mm256_storeu_ps(dst + i, d);
+    }
+    return i;
+}
+#endif
+
+/**
+ * dst[i] += scale * src[i]
+ */
+void light_axpy(float *dst, const float *src, float scale, size_t n)
+{
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256 vs = _mm256_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_loadu_ps(dst + i);
+        d = _mm256_add_ps(d, _mm256_mul_ps(vs, _mm256_loadu_ps(src + i)));
+        _mm256_storeu_ps(dst + i, d);
+    }
+#elif defined(__SSE2__)
+#ifdef LIGHT_AVX2_DISPATCH
+    if (__builtin_cpu_supports("avx2")) i = light_axpy_avx2(dst, src, scale, n);
+#endif
+    __m128 vs = _mm_set1_ps(scale);
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_loadu_ps(dst + i);
+        d = _mm_add_ps(d, _mm_mul_ps(vs, _mm_loadu_ps(src + i)));
+        _mm_storeu_ps(dst + i, d);
+    }
+#elif defined(__wasm_simd128__)
+    v128_t vs = wasm_f32x4_splat(scale);
+    for (; i + 4 <= n; i += 4) {
+        v128_t d = wasm_v128_load(dst + i);
+        d = wasm_f32x4_add(d, wasm_f32x4_mul(vs, wasm_v128_load(src + i)));
+        wasm_v128_store(dst + i, d);
+    }
+#endif
+    for (; i < n; ++i) {
+        dst[i] += scale * src[i];
+    }
+}
+
+/**
+ * Adds the weights k of one source to n consecutive cells starting at off
+ */
+void light_accumulate(LightPlanes *lp, size_t off, const float *k, size_t n, LightSource src)
+{
+    light_axpy(lp->r + off, k, src.r, n);
+    light_axpy(lp->g + off, k, src.g, n);
+    light_axpy(lp->b + off, k, src.b, n);
+    light_axpy(lp->w + off, k, 1.f, n);
+}
+
+/**
+ * light_splat limited to rows [y0, y1)
+ */
+void light_splat_rows(LightPlanes *lp, LightGrid grid, LightSource src, float scale, size_t y0, size_t y1)
+{
+    LightRect rect = light_rect(grid, src.x, src.y);
+    rect.y0 = MAX(rect.y0, y0);
+    rect.y1 = MIN(rect.y1, y1);
+    if (rect.y0 >= rect.y1) return;
+
+    size_t width = rect.x1 - rect.x0;
+    float k[width];
+    float strength = src.strength * scale;
+
+    size_t row, col;
+    for (row = rect.y0; row < rect.y1; ++row) {
+        size_t dy = row > src.y ? row - src.y : src.y - row;
+        // Falloff is read forwards right of the source and backwards left of it
+        for (col = rect.x0; col < src.x; ++col) {
+            k[col - rect.x0] = grid.falloff[dy + src.x - col] * strength;
+        }
+        for (col = src.x; col < rect.x1; ++col) {
+            k[col - rect.x0] = grid.falloff[dy + col - src.x] * strength;
+        }
+        if (grid.heights != NULL) {
+            for (col = rect.x0; col < rect.x1; ++col) {
+                if (!light_is_visible(grid, src, col, row)) k[col - rect.x0] = 0.f;
+            }
+        }
+        light_accumulate(lp, row * grid.cols + rect.x0, k, width, src);
+    }
+}
+
+/**
+ * Adds scale times the contribution of a source to every cell it reaches.
+ * A negative scale removes a contribution added before
+ */
+void light_splat(LightPlanes *lp, LightGrid grid, LightSource src, float scale)
+{
+    ASSERT(lp->len == grid.cols * grid.rows, "Planes do not match grid");
+    light_splat_rows(lp, grid, src, scale, 0, grid.rows);
+}
+
+typedef struct LightJob {
+    LightPlanes *lp;
+    LightGrid grid;
+    const LightSource *srcs;
+    const float *scales;
+    size_t count;
+    size_t tiles;
+} LightJob;
+
+/**
+ * Every source in order, for the rows of one tile. A cell is only written by
+ * the tile holding it and always sums its sources in the same order, so the
+ * result does not depend on how tiles are spread over threads.
+ */
+static void light_job_tile(const LightJob *job, size_t tile)
+{
+    size_t y0 = tile * LIGHT_TILE_ROWS;
+    size_t y1 = MIN(y0 + LIGHT_TILE_ROWS, job->grid.rows);
+    size_t i;
+    for (i = 0; i < job->count; ++i) {
+        if (job->scales[i] == 0.f) continue;
+        light_splat_rows(job->lp, job->grid, job->srcs[i], job->scales[i], y0, y1);
+    }
+}
+
+#ifndef PLATFORM_WEB
+/**
+ * Workers sleep on start until a job is posted, then take tiles until none
+ * are left. The posting thread works on tiles as well.
+ */
+static struct {
+    bool running;
+    bool quit;  /* Set by light_pool_free, workers return on waking up */
+    size_t workers;
+    size_t active;  /* Workers taking part in the current job */
+    pthread_t threads[LIGHT_THREADS_MAX];
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    const LightJob *job;
+    size_t generation;
+    size_t next_tile;
+    size_t busy;
+} pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+static void light_pool_work(const LightJob *job)
+{
+    for (;;) {
+        pthread_mutex_lock(&pool.mutex);
+        size_t tile = pool.next_tile++;
+        pthread_mutex_unlock(&pool.mutex);
+        if (tile >= job->tiles) return;
+        light_job_tile(job, tile);
+    }
+}
+
+static void *light_pool_worker(void *arg)
+{
+    size_t id = (size_t) arg;
+    size_t seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool.mutex);
+        while (pool.generation == seen && !pool.quit) {
+            pthread_cond_wait(&pool.start, &pool.mutex);
+        }
+        if (pool.quit) {
+            pthread_mutex_unlock(&pool.mutex);
+            return NULL;
+        }
+        seen = pool.generation;
+        const LightJob *job = pool.job;
+        bool active = id < pool.active;
+        pthread_mutex_unlock(&pool.mutex);
+        if (!active) continue;
+
+        light_pool_work(job);
+
+        pthread_mutex_lock(&pool.mutex);
+        pool.busy -= 1;
+        if (pool.busy == 0) pthread_cond_signal(&pool.done);
+        pthread_mutex_unlock(&pool.mutex);
+    }
+}
+
+static void light_pool_run(const LightJob *job, size_t threads)
+{
+    if (!pool.running) {
+        pool.workers = 0;
+        pool.running = true;
+        size_t i;
+        for (i = 0; i < LIGHT_THREADS_MAX - 1; ++i) {
+            if (pthread_create(&pool.threads[i], NULL, light_pool_worker, (void *) i) != 0) break;
+            pool.workers += 1;
+        }
+    }
+    size_t workers = MIN(threads - 1, pool.workers);
+
+    pthread_mutex_lock(&pool.mutex);
+    pool.job = job;
+    pool.next_tile = 0;
+    pool.active = workers;
+    pool.busy = workers;
+    pool.generation += 1;
+    pthread_mutex_unlock(&pool.mutex);
+
+    // Every worker wakes up, but only the first active ones take tiles
+    if (workers > 0) pthread_cond_broadcast(&pool.start);
+    light_pool_work(job);
+
+    pthread_mutex_lock(&pool.mutex);
+    while (pool.busy > 0) {
+        pthread_cond_wait(&pool.done, &pool.mutex);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+}
+#endif
+
+/**
+ * Stops and joins the workers of light_compute. A later call starts them
+ * again
+ */
+void light_pool_free(void)
+{
+#ifndef PLATFORM_WEB
+    if (!pool.running) return;
+    pthread_mutex_lock(&pool.mutex);
+    pool.quit = true;
+    pthread_mutex_unlock(&pool.mutex);
+    pthread_cond_broadcast(&pool.start);
+    size_t i;
+    for (i = 0; i < pool.workers; ++i) {
+        pthread_join(pool.threads[i], NULL);
+    }
+    // Workers started later wait for the next job from generation 0
+    pool.workers = 0;
+    pool.generation = 0;
+    pool.running = false;
+    pool.quit = false;
+#endif
+}
+
+/**
+ * Cores available for light_compute. Always 1 on web
+ */
+size_t light_threads_default(void)
+{
+#ifdef PLATFORM_WEB
+    return 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n < 1 ? 1 : MIN((size_t) n, LIGHT_THREADS_MAX);
+#endif
+}
+
+/**
+ * Splats every source with its scale. Rooms of at least LIGHT_PARALLEL_CELLS
+ * cells are split in tiles of LIGHT_TILE_ROWS rows and spread over threads.
+ * The result is bit identical for any thread count.
+ */
+void light_compute(LightPlanes *lp, LightGrid grid, const LightSource *srcs, const float *scales, size_t count, size_t threads)
+{
+    ASSERT(lp->len == grid.cols * grid.rows, "Planes do not match grid");
+
+    LightJob job = {
+        .lp = lp,
+        .grid = grid,
+        .srcs = srcs,
+        .scales = scales,
+        .count = count,
+        .tiles = (grid.rows + LIGHT_TILE_ROWS - 1) / LIGHT_TILE_ROWS,
+    };
+
+#ifndef PLATFORM_WEB
+    if (threads > 1 && lp->len >= LIGHT_PARALLEL_CELLS && job.tiles > 1) {
+        light_pool_run(&job, MIN(threads, LIGHT_THREADS_MAX));
+        return;
+    }
+#endif
+    (void) threads;
+    size_t tile;
+    for (tile = 0; tile < job.tiles; ++tile) {
+        light_job_tile(&job, tile);
+    }
+}
+
+void light_add_layer(LightPlanes *lp, const LightBake *bake, size_t layer, float scale)
+{
+    ASSERT(lp->len == bake->cells, "Planes do not match bake");
+    ASSERT(layer < bake->layers, "Layer out of range");
+
+    // Planes are allocated back to back. See light_planes_init
+    const float *src = bake->data + layer * LIGHT_PLANES * bake->cells;
+    light_axpy(lp->r, src, scale, LIGHT_PLANES * bake->cells);
+}
+
+/**
+ * light_add_layer limited to the cells of rect
+ */
+void light_add_layer_rect(LightPlanes *lp, const LightBake *bake, size_t layer, float scale, LightRect rect, size_t cols)
+{
+    ASSERT(lp->len == bake->cells, "Planes do not match bake");
+    ASSERT(layer < bake->layers, "Layer out of range");
+
+    float *dst[LIGHT_PLANES] = { lp->r, lp->g, lp->b, lp->w };
+    const float *src = bake->data + layer * LIGHT_PLANES * bake->cells;
+    size_t p, row;
+    for (p = 0; p < LIGHT_PLANES; ++p) {
+        for (row = rect.y0; row < rect.y1; ++row) {
+            size_t off = row * cols + rect.x0;
+            light_axpy(dst[p] + off, src + p * bake->cells + off, scale, rect.x1 - rect.x0);
+        }
+    }
+}
+
+/**
+ * Delta updates can leave planes slightly below zero, hence the clamping
+ */
+Color light_resolve(const LightPlanes *lp, size_t i)
+{
+    float norm = 255.f / (1.f + MAX(lp->w[i], 0.f));
+    return (Color) {
+        .r = MIN(MAX(lp->r[i] * norm, 0.f), 255.f),
+        .g = MIN(MAX(lp->g[i] * norm, 0.f), 255.f),
+        .b = MIN(MAX(lp->b[i] * norm, 0.f), 255.f),
+        .a = 255,
+    };
+}
+
+/**
+ * FNV-1a. Used to tell if a bake is stale
+ */
+u32 light_hash(const u16 *data, size_t len)
+{
+    u32 hash = 2166136261u;
+    size_t i;
+    for (i = 0; i < len; ++i) {
+        hash = (hash ^ (data[i] & 0xff)) * 16777619u;
+        hash = (hash ^ (data[i] >> 8)) * 16777619u;
+    }
+    return hash;
+}
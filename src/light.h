@@ -0,0 +1,101 @@
+#ifndef LIGHT_H
+#define LIGHT_H
+
+#include "core.h"
+
+/**
+ * Light model shared by the game and the bake tool
+ *
+ * Every source adds k * color to the r, g, b planes and k to the w plane,
+ * where k is the source strength over the squared manhattan distance. The
+ * lit color of a cell is rgb / (1 + w). Contributions are summed, so layers
+ * baked per source can be added at runtime in any order.
+ */
+
+#define LIGHT_LAYERS_MAX 8
+#define LIGHT_PLANES 4  /* r, g, b, w */
+#define LIGHT_OCCLUDER_HEIGHT 3  /* Cells this tall cast shadows */
+#define LIGHT_RADIUS 16  /* Manhattan distance past which a source adds nothing */
+#define LIGHT_TILE_ROWS 16  /* Rows per tile of light_compute */
+#define LIGHT_PARALLEL_CELLS (64 * 64)  /* Smaller rooms are lit on one thread */
+#define LIGHT_THREADS_MAX 32
+
+#if defined(__AVX2__)
+    #define LIGHT_SIMD "avx2"
+#elif defined(__SSE2__)
+    #define LIGHT_SIMD "sse2"
+#elif defined(__wasm_simd128__)
+    #define LIGHT_SIMD "simd128"
+#else
+    #define LIGHT_SIMD "scalar"
+#endif
+
+typedef struct LightSource {
+    u32 x;
+    u32 y;
+    float r;  /* [0, 1] */
+    float g;
+    float b;
+    float strength;
+} LightSource;
+
+typedef struct LightGrid {
+    size_t cols;
+    size_t rows;
+    size_t radius;  /* Cutoff of the sources. Must match the falloff table */
+    const u8 *heights;  /* Height of each cell. NULL disables occlusion */
+    const float *falloff;  /* Indexed by manhattan distance. See light_falloff_init */
+} LightGrid;
+
+/**
+ * Cells [x0, x1) x [y0, y1)
+ */
+typedef struct LightRect {
+    size_t x0;
+    size_t y0;
+    size_t x1;
+    size_t y1;
+} LightRect;
+
+typedef struct LightPlanes {
+    float *r;
+    float *g;
+    float *b;
+    float *w;
+    size_t len;
+} LightPlanes;
+
+/**
+ * Light of one room, generated by `make bake`
+ * Layer l, plane p of cell i is at data[(l * LIGHT_PLANES + p) * cells + i]
+ */
+typedef struct LightBake {
+    u32 hash;  /* light_hash of the world data it was baked from */
+    size_t cells;
+    size_t layers;
+    int source[LIGHT_LAYERS_MAX];  /* Cell index of the switchable source. -1 for static lights */
+    const float *data;
+} LightBake;
+
+float *light_falloff_init(size_t cols, size_t rows, size_t radius);
+LightRect light_rect(LightGrid grid, size_t x, size_t y);
+bool light_is_visible(LightGrid grid, LightSource src, size_t x, size_t y);
+float light_weight(LightGrid grid, LightSource src, size_t x, size_t y);
+
+void light_planes_init(LightPlanes *lp, size_t len);
+void light_planes_clear(LightPlanes *lp);
+void light_planes_free(LightPlanes *lp);
+void light_axpy(float *dst, const float *src, float scale, size_t n);
+void light_accumulate(LightPlanes *lp, size_t off, const float *k, size_t n, LightSource src);
+void light_splat_rows(LightPlanes *lp, LightGrid grid, LightSource src, float scale, size_t y0, size_t y1);
+void light_splat(LightPlanes *lp, LightGrid grid, LightSource src, float scale);
+size_t light_threads_default(void);
+void light_compute(LightPlanes *lp, LightGrid grid, const LightSource *srcs, const float *scales, size_t count, size_t threads);
+void light_pool_free(void);
+void light_add_layer(LightPlanes *lp, const LightBake *bake, size_t layer, float scale);
+void light_add_layer_rect(LightPlanes *lp, const LightBake *bake, size_t layer, float scale, LightRect rect, size_t cols);
+Color light_resolve(const LightPlanes *lp, size_t i);
+
+u32 light_hash(const u16 *data, size_t len);
+
+#endif  /* LIGHT_H */
@@ -4,9 +4,17 @@
 #include <math.h>
 
 #include "core.h"
+#include "world.h"
+#include "light.h"
+#include "draw.h"
+#include "font.h"
+#include "shader.h"
+#include "canvas.h"
+#include "layout.h"
 #include "../assets/atlas.h"
 #include "../assets/world_atlas.h"
 #include "../assets/player_atlas.h"
+#include "../assets/world_light.h"
 #define CASE_IMPLEMENTATION
 #include "case.h"
 #define NO_TEMPLATE
@@ -29,120 +37,11 @@
 
 #define TIME_LIGHT_MAX 0.1f
 #define TIME_LIGHT_MIN 0.02f
-
-/**
- * New format
- * 0bxxxx0000: physical {type1[empty, ground, blinds, bed, door, puzzle1, puzzle2, window](3), height(1)}
- * 4 bits for type: [empty, ground, blinds, bed, door, puzzle1, puzzle2, window]
- * 2 bit for height: unwalkable, 1, 2, 3
- * 2 bits reserved for metadata
- *
- * 0b0000xxxx: visual {2 type[empty, light, 2`reserved], 2 color, 4 brightness} (1)
- * 2 bits type: [empty, spawn, `reserved`, `reserved`]
- * 2 bits color: [white, blue, pink, black]
- * 4 bits for brightness: 0-15
- */
-
-/* Visual masks */
-#define MASK_PHYSICAL(a) ((a) & 0b11111111)
-#define MASK_PHYSICAL_T(a) ((a) & 0b00001111)
-#define MASK_HEIGHT(a) ((a) & 0b00110000)
-#define MASK_META(a) ((a) & 0b11000000)
-
-/* Visual masks */
-#define MASK_VISUAL(a) ((a) & (0b1111111 << 8))
-#define MASK_VISUAL_T(a) ((a) & (0b0000011 << 8))
-#define MASK_COLOR(a) ((a) & 0b00001100 << 8)
-#define MASK_BRIGHTNESS(a) ((a) & 0b11110000 << 8)
-
-enum PhysicalType {
-    PEMPTY = 0b0000,    /* Don't render anything */
-    PGROUND = 0b0001,   /* Walkable */
-    PBLINDS = 0b0010,   /* -Energy +Light */
-    PBED = 0b0011,      /* Restart day / spawn */
-    PDOOR = 0b0100,     /* Finish when exit / Big puzzle */
-    PPUZZLE1 = 0b0101,  /* Puzzle for exercise */
-    PPUZZLE2 = 0b0110,  /* Puzzle for fun */
-    PWINDOW = 0b0111,   /* Window for seeing things */
-    PBED_END = 0b1000,  /* Bed part II */
-    PTABLE = 0b1001,    /* You know */
-    PBOSS = 0b1010,     /* You know */
-    PTABLE_TL = 0b1011, /* Main table */
-    PTABLE_BL = 0b1100, /* Main table */
-    PTABLE_TR = 0b1101, /* Main table */
-    PTABLE_BR = 0b1110, /* Main table */
-    // PWALL = 0b1001, /* Window for seeing things */
-};
-
-enum PHeight {
-    UNWALKABLE = 0b00 << 4,
-    H1         = 0b01 << 4,
-    H2         = 0b10 << 4,
-    H3         = 0b11 << 4,
-};
-
-enum VisualType {
-    VEMPTY  = 0b00 << 8,  /* Don't render anything */
-    VSPAWN  = 0b01 << 8,  /* Spawn point */
-};
-
-enum VisualColor {
-    VWHITE = 0b00 << 10,
-    VBLUE = 0b01 << 10,
-    VPINK = 0b10 << 10,
-    VBLACK = 0b11 << 10,
-};
-
-#define VSTRENGTH(a) ((a) << 12)
-#define PMETA(a) ((a) <<  6)
-
-#define S (PBED | H2)
-#define Se (PBED_END | H2 | VSPAWN)
-#define G (PGROUND | H1)
-#define D0 (PDOOR | H1 | PMETA(0b00))
-#define D1 (PDOOR | H1 | PMETA(0b01)) /* Meta roomid */
-#define Db (PBOSS | H1 | PMETA(0b10)) /* Boss door */
-#define P1 (PPUZZLE1 | H2 | VPINK | VSTRENGTH(0b1111))
-#define P2 (PPUZZLE2 | H1 | VBLUE | VSTRENGTH(0b1111))
-#define Ld (PWINDOW | UNWALKABLE | PMETA(0b01) | VWHITE | VSTRENGTH(0b1111)) /* Meta off on */
-#define Lb (PWINDOW | UNWALKABLE | PMETA(0b01) | VPINK | VSTRENGTH(0b0011))  /* Meta off on */
-#define B (PBLINDS | H1)
-#define T (PTABLE | H3)
-#define Tl (PTABLE_TL | H3)
-#define Tr (PTABLE_TR | H3)
-#define Bl (PTABLE_BL | H3)
-#define Br (PTABLE_BR | H3)
-
-/**
- * Header:
- * cols, rows
- * Body: world format (len = width * height)
- *
- */
-static u16 worlds[2][103] = {
-    {
-        6, 7,
-        0, 0, 0, 0, D1,0,
-        G, G, G, G, G, G,
-        T, G, G, G, G, G,
-        S, Se,G, G, G ,G,
-        G, G, G, G, G ,G,
-        G, G, G, B, G, G,
-        0, 0, Ld,Ld,0, 0,
-    },
-    {
-        6, 9,
-        0, 0, 0, 0, 0, 0,
-        0, G, G, Tl,Tr,G,
-        Db,G, G, Bl,Br,G,
-        0, G, G, G, P1,G,
-        0, P2,G, G, G, G,
-        0, G, G, G, G, G,
-        0, G, G, G, G, G,
-        0, G, G, G, G, G,
-        0, 0, 0, 0,D0, 0,
-    }
-};
+#define TIME_LIGHT_BUCKETS 32  /* Steps of window light before relighting */
+#define WORLD_LIGHTS_MAX 16  /* Lights uploaded to world_fs. Keep in sync with MAX_LIGHTS */
+#define LIGHT_DELTAS_MAX 64  /* Delta updates before the light planes are rebuilt */
+#define IDLE_WAIT (1.f / 60.f)  /* Seconds between input polls while no frame is drawn */
+#define IDLE_WEB_INTERVAL 50  /* Milliseconds between main loop calls while idle on web */
 
 typedef struct U32x2 {
     u32 x;
@@ -160,6 +59,37 @@ typedef struct Cell {
     Color color;
 } Cell;
 
+typedef struct Light {
+    U32x2 pos;
+    enum VisualColor color;
+    u8 strength;  /* MASK_BRIGHTNESS of the source cell */
+    bool is_window;  /* Scaled by time of day and hidden by blinds */
+} Light;
+
+/**
+ * Everything apply_lighting depends on. Lighting is only recomputed when the
+ * key of the current frame differs from the one of the cached result.
+ */
+typedef struct LightKey {
+    u16 world_id;
+    bool blinds_down;
+    int time_bucket;  /* -1 when no window lets light in */
+} LightKey;
+
+/**
+ * Everything the static cell layer depends on. The layer is redrawn into its
+ * render texture only when this differs from the key it was baked with.
+ */
+typedef struct LayerKey {
+    size_t light_version;
+    bool blinds_down;
+    float brightness;
+    float cell_width;
+    int width;
+    int height;
+    unsigned int atlas_id;
+} LayerKey;
+
 typedef struct World {
     Player player;
     size_t cols;
@@ -168,10 +98,30 @@ typedef struct World {
     U32x2 camera_pos;
     u16 world_id;
 
-    // Following are set at start of render function and in view space
+    // Following are built by load_world
+    Light *light_case;
+    float *falloff;  /* Inverse square falloff indexed by manhattan distance */
+    u8 *heights;  /* Height of each cell, for occlusion */
+    const LightBake *bake;  /* NULL if the room has no up to date bake */
+    LightSource *light_sources;  /* light_case as passed to light_compute */
+    float *light_scales;
+    LightPlanes planes;
+    HeightEdges edges;
+
+    LightKey light_key;
+    bool light_dirty;  /* Set when the light sources change. Forces recompute */
+    size_t light_deltas;  /* Delta updates since the last recompute */
+    size_t light_version;  /* Bumped whenever cell colors change */
+
+    RenderTexture2D layer;  /* Static cells. id is 0 until first baked */
+    LayerKey layer_key;
+    size_t layer_draws;  /* Cells drawn into layer by the last bake */
+
+    // Following are set by world_layout and in view space
     float cell_width;
     Vector2 wpos;
     Vector2 wdim;
+    size_t layout_version;  /* Of the layout they were computed for */
 } World;
 
 typedef struct Sleep {
@@ -183,6 +133,21 @@ typedef struct Sleep {
     float end_pain;
 } Sleep;
 
+/**
+ * Scene under a modal state, drawn once on entry and blitted under the
+ * overlay until the state is left. Redrawn when the canvas size changes
+ */
+typedef struct Backdrop {
+    RenderTexture2D target;  /* id 0 until first captured */
+    GameState state;  /* Modal state it was captured for */
+    bool valid;
+} Backdrop;
+
+typedef enum {
+    LIGHTING_CPU,  /* apply_lighting writes cell colors */
+    LIGHTING_GPU,  /* world_fs shades the cells per pixel */
+} LightingBackend;
+
 typedef struct {
     size_t frame;
     Texture2D atlas;
@@ -198,76 +163,155 @@ typedef struct {
     PlayerState pstate;
     Sleep sleep;
     bool blinds_down;
-    Shader puzzle_shader;
+    ShaderProgram *world_shader;
+    ShaderProgram *tilemap_shader;
+    LightingBackend lighting;
+    PuzzleRenderer puzzle_renderer;
+    bool idle_skip;  /* Skip drawing frames whose output would not change */
+    bool is_idle;  /* Last frame was skipped */
+    size_t drawn_in_row;  /* Frames drawn since the last skipped one */
+    GameState drawn_state;  /* State of the last drawn frame */
+    GameState menu_over;  /* State the menu was opened from, MENU if none */
+    Backdrop backdrop;
+
+    size_t light_hits;        /* Frames served from the lighting cache */
+    size_t light_recomputes;  /* Frames where apply_lighting had to run */
+    size_t light_deltas;  /* Frames where only changed sources were relit */
+    size_t light_recomputes_frame;
+    size_t layer_bakes;  /* Times the static cell layer was redrawn */
+    size_t layer_draws_saved;  /* Cell draws replaced by a layer blit */
+    size_t frames_skipped;
+    size_t backdrop_captures;
+    size_t backdrop_frames;  /* Frames drawn from a captured backdrop */
 } GO;
 
 GO go = { 0 };
 
-static char *vs =
+/**
+ * Same light model as light_splat, evaluated for the cell under each
+ * fragment. Light positions are in cells, colors are normalized.
+ * Occlusion is not evaluated.
+ */
+static char *world_fs =
 	"#version 100\n"
 	"\n"
-	"// Input vertex attributes\n"
-	"attribute vec3 vertexPosition;\n"
-	"attribute vec2 vertexTexCoord;\n"
-	"attribute vec3 vertexNormal;\n"
-	"attribute vec4 vertexColor;\n"
+	"precision mediump float;\n"
 	"\n"
-	"// Input uniform values\n"
-	"uniform mat4 mvp;\n"
+	"#define MAX_LIGHTS 16\n"
 	"\n"
-	"// Output vertex attributes (to fragment shader)\n"
 	"varying vec2 fragTexCoord;\n"
 	"varying vec4 fragColor;\n"
 	"\n"
+	"uniform sampler2D texture0;\n"
+	"uniform vec4 colDiffuse;\n"
+	"uniform vec2 wpos;\n"
+	"uniform float cell_width;\n"
+	"uniform float screen_height;\n"
+	"uniform float brightness;\n"
+	"uniform float radius;\n"
+	"uniform int light_count;\n"
+	"uniform vec4 lights[MAX_LIGHTS];\n"
+	"uniform vec4 light_colors[MAX_LIGHTS];\n"
+	"\n"
 	"void main()\n"
 	"{\n"
-	"    // Send vertex attributes to fragment shader\n"
-	"    fragTexCoord = vertexTexCoord;\n"
-	"    fragColor = vertexColor;\n"
-	"\n"
-	"    // Calculate final vertex position\n"
-	"    gl_Position = mvp*vec4(vertexPosition, 1.0);\n"
-	"}\n"
-	"\n";
+	"    vec4 texelColor = texture2D(texture0, fragTexCoord);\n"
+	"    vec2 pos = vec2(gl_FragCoord.x, screen_height - gl_FragCoord.y);\n"
+	"    vec2 cell = floor((pos - wpos) / cell_width);\n"
+	"    vec4 acc = vec4(0.0);\n"
+	"    for (int i = 0; i < MAX_LIGHTS; ++i)\n"
+	"    {\n"
+	"        if (i >= light_count) break;\n"
+	"        vec2 d = abs(cell - lights[i].xy);\n"
+	"        float dist = d.x + d.y;\n"
+	"        float k = dist > radius ? 0.0 : lights[i].z / max(dist * dist, 1.0);\n"
+	"        acc += k * vec4(light_colors[i].rgb, 1.0);\n"
+	"    }\n"
+	"    vec3 lit = acc.rgb / (1.0 + acc.a);\n"
+	"    vec3 tint = lit + (1.0 - lit) * brightness;\n"
+	"    gl_FragColor = texelColor * fragColor * vec4(tint, 1.0);\n"
+	"}\n";
 
-static char *fs =
+/**
+ * Puzzle board for PUZZLE_RENDER_TILEMAP. The info byte of each cell is read
+ * from tilemap (height in bits 0-1, type in bits 2-3). Draws what the cells,
+ * grid, height lines and border of PUZZLE_RENDER_CELLS draw. Positions are
+ * in screen pixels.
+ */
+static char *tilemap_fs =
 	"#version 100\n"
 	"\n"
-	"\n"
 	"precision mediump float;\n"
 	"\n"
 	"varying vec2 fragTexCoord;\n"
 	"varying vec4 fragColor;\n"
 	"\n"
+	"uniform sampler2D texture0;\n"
+	"uniform sampler2D tilemap;\n"
+	"uniform vec4 colDiffuse;\n"
+	"uniform vec4 board;\n"
+	"uniform vec2 dim;\n"
+	"uniform vec2 atlas_size;\n"
+	"uniform vec4 edge_color;\n"
+	"uniform float screen_height;\n"
 	"\n"
-    "uniform sampler2D texture0;\n"
-    "uniform vec4 colDiffuse;\n"
-	"uniform vec2 center;\n"
-	"uniform float radius;\n"
+	"float info_at(vec2 cell)\n"
+	"{\n"
+	"    return floor(texture2D(tilemap, (cell + 0.5) / dim).r * 255.0 + 0.5);\n"
+	"}\n"
+	"\n"
+	"// Covered by the edge to neighbour n, dist pixels away\n"
+	"bool is_edge(float height, vec2 n, float dist)\n"
+	"{\n"
+	"    if (n.x < 0.0 || n.y < 0.0 || n.x >= dim.x || n.y >= dim.y) return false;\n"
+	"    return dist < 1.5 * abs(height - mod(info_at(n), 4.0));\n"
+	"}\n"
 	"\n"
 	"void main()\n"
 	"{\n"
-    "    vec4 texelColor = texture2D(texture0, fragTexCoord);\n"
-    "    float lhs = pow(center.x - gl_FragCoord.x, 2.0) + pow(center.y - gl_FragCoord.y, 2.0);\n"
-    "    float rhs = pow(radius, 2.0);\n"
-	"    if (lhs < rhs)\n"
+	"    vec2 pos = vec2(gl_FragCoord.x, screen_height - gl_FragCoord.y) - board.xy;\n"
+	"    float cell_width = board.z / dim.x;\n"
+	"    vec2 cell = clamp(floor(pos / cell_width), vec2(0.0), dim - 1.0);\n"
+	"    vec2 f = pos - cell * cell_width;\n"
+	"    float info = info_at(cell);\n"
+	"    float height = mod(info, 4.0);\n"
+	"    float goal = mod(floor(info / 4.0), 4.0) == 2.0 ? 1.0 : 0.0;\n"
+	"    vec2 uv = (vec2(height, goal) + clamp(f / cell_width, 0.0, 1.0)) * 8.0 / atlas_size;\n"
+	"    vec4 texelColor = texture2D(texture0, uv);\n"
+	"\n"
+	"    if (f.x < 0.5 || f.y < 0.5 || f.x > cell_width - 0.5 || f.y > cell_width - 0.5)\n"
 	"    {\n"
-	"        gl_FragColor = mix(texelColor, vec4(0.0, 0.0, 0.0, 1.0), lhs / rhs);\n"
+	"        texelColor = vec4(1.0);\n"
 	"    }\n"
-	"    else\n"
+	"    if (is_edge(height, cell - vec2(1.0, 0.0), f.x) || is_edge(height, cell + vec2(1.0, 0.0), cell_width - f.x) ||\n"
+	"        is_edge(height, cell - vec2(0.0, 1.0), f.y) || is_edge(height, cell + vec2(0.0, 1.0), cell_width - f.y))\n"
 	"    {\n"
-	"        gl_FragColor = vec4(0.0, 0.0, 0.0, 1.0);\n"
+	"        texelColor = edge_color;\n"
 	"    }\n"
+	"    if (pos.x < 3.0 || pos.y < 3.0 || pos.x > board.z - 3.0 || pos.y > board.w - 3.0)\n"
+	"    {\n"
+	"        texelColor = vec4(1.0);\n"
+	"    }\n"
+	"    gl_FragColor = texelColor;\n"
 	"}\n";
 
+static const char *world_uniforms[] = {
+    "wpos", "cell_width", "screen_height", "brightness", "radius", "light_count", "lights", "light_colors",
+};
+static const char *tilemap_uniforms[] = {
+    "tilemap", "board", "dim", "atlas_size", "edge_color", "screen_height",
+};
+
 
 /* Door 0, 1, 2, 3, spawnpoint */
 World *load_world(u16 world_id, u8 spawn);
+void world_layout(World *w);
 GameState update_world(World *w, PlayerState *pstate);
+void render_world_scene(World *w, PlayerState pstate, Texture2D atlas, Texture2D player_atlas);
 void render_world(World *w, PlayerState pstate, Texture2D atlas, Texture2D player_atlas);
 void free_world(World *w);
 GameState update_sleep(World **w, Sleep *s, PlayerState *pstate, GameState gs);
-void render_sleep(World *w, Sleep s, PlayerState pstate, Texture2D atlas, Texture2D player_atlas);
+void render_sleep(World *w, Sleep s, PlayerState pstate, Texture2D atlas);
 
 GameState update_victory();
 void render_victory(World *w, PlayerState pstate, Texture2D atlas, Texture2D player_atlas);
@@ -275,6 +319,13 @@ void render_victory(World *w, PlayerState pstate, Texture2D atlas, Texture2D pla
 void render_menu(void);
 GameState update_menu(void);
 
+void backdrop_update(GameState state);
+void backdrop_draw(Color tint);
+void backdrop_free(void);
+
+#ifdef DEBUG
+void render_debug(void);
+#endif
 
 
 void loop(void);
@@ -283,8 +334,11 @@ int main(void)
 {
     int width = WIDTH;
     int height = HEIGHT;
-    SetConfigFlags(/* FLAG_VSYNC_HINT | FLAG_WINDOW_RESIZABLE | */ FLAG_MSAA_4X_HINT);
+    SetConfigFlags(/* FLAG_VSYNC_HINT | */ FLAG_WINDOW_RESIZABLE | FLAG_MSAA_4X_HINT);
     InitWindow(width, height, "Transition #3");
+    SetWindowMinSize(CANVAS_BASE_WIDTH, CANVAS_BASE_HEIGHT);
+    canvas_set_enabled(true);
+    font_init();
 
     Image atlas_img = {
         .data = ATLAS_DATA,
@@ -319,8 +373,8 @@ int main(void)
     go.pstate.energy = ENERGY_MAX_INIT;  // orig 0.3f
     go.pstate.energy_max = ENERGY_MAX_INIT;
     go.pstate.energy_lim = ENERGY_MAX_LIM;
-    go.pstate.pain = 0.2f;
-    go.pstate.pain_max = 1.f;
+    go.pstate.pain = PAIN_INIT;
+    go.pstate.pain_max = PAIN_MAX;
     go.pstate.time = 0.3334; /* 08:00 */
     go.pstate.did_faint = false;
     go.pstate.face_id = 0;
@@ -332,7 +386,14 @@ int main(void)
     go.puzzle_train = load_puzzle(puzzle_train_array[go.puzzle_train_id]);
     go.puzzle_boss = load_puzzle(puzzle_boss);
     go.blinds_down = true;
-    go.puzzle_shader = LoadShaderFromMemory(vs, fs);
+    go.world_shader = shader_load("world", shader_vs, world_fs, world_uniforms, sizeof world_uniforms / sizeof *world_uniforms);
+    go.tilemap_shader = shader_load("tilemap", shader_vs, tilemap_fs, tilemap_uniforms, sizeof tilemap_uniforms / sizeof *tilemap_uniforms);
+    go.lighting = LIGHTING_CPU;
+    go.puzzle_renderer = PUZZLE_RENDER_TILEMAP;
+    go.idle_skip = true;
+    go.is_idle = false;
+    go.drawn_in_row = 0;
+    go.menu_over = MENU;
 
 
     SetExitKey(0);
@@ -347,20 +408,102 @@ int main(void)
 #endif
 
     UnloadTexture(go.atlas);
-    UnloadShader(go.puzzle_shader);
     free_puzzle(go.puzzle_fun);
     free_puzzle(go.puzzle_train);
+    puzzle_free_resources();
     free_world(go.world);
+    light_pool_free();
+    backdrop_free();
+    free_hud();
+    font_free();
+    shader_unload_all();
+    canvas_free();
     CloseWindow();
     return 0;
 }
 
 
+/**
+ * Any key pressed this frame, or a move modifier released
+ */
+bool key_input(void)
+{
+    bool input = false;
+    while (GetKeyPressed() != 0) input = true;
+    return input || IsKeyReleased(KEY_LEFT_SHIFT) || IsKeyReleased(KEY_RIGHT_SHIFT) || IsKeyReleased(KEY_U);
+}
+
+bool mouse_input(void)
+{
+    Vector2 delta = GetMouseDelta();
+    return delta.x != 0.f || delta.y != 0.f
+        || IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || IsMouseButtonReleased(MOUSE_LEFT_BUTTON);
+}
+
+/**
+ * Whether the output of state may differ from the last drawn frame.
+ * animating is whether a player animation ran at the start of the frame
+ */
+bool state_is_dirty(GameState state, bool animating)
+{
+    switch (state) {
+        case MENU: { return key_input(); } break;
+        case PUZZLE_FUN_WIN:
+        case PUZZLE_TRAIN_WIN:
+        case PUZZLE_BOSS_WIN: { return animating || key_input(); } break;
+        case PUZZLE_FUN:
+        case PUZZLE_TRAIN:
+        case PUZZLE_BOSS: { return animating || key_input() || mouse_input(); } break;
+        case WORLD: { return animating || key_input(); } break;
+        case SLEEP:
+        case FAINT: { return true; } break;  /* Time advances every frame */
+    }
+    ASSERT(0, "Unreachable");
+}
+
+/**
+ * Stands in for EndDrawing on frames that are not drawn. The last frame stays
+ * on screen. Web builds are throttled by the main loop timing instead
+ */
+void idle_wait(void)
+{
+#if defined(PLATFORM_WEB)
+    if (!go.is_idle) emscripten_set_main_loop_timing(EM_TIMING_SETTIMEOUT, IDLE_WEB_INTERVAL);
+#else
+    WaitTime(IDLE_WAIT);
+#endif
+    PollInputEvents();
+    go.is_idle = true;
+    go.drawn_in_row = 0;
+    go.frames_skipped += 1;
+}
+
+void idle_resume(void)
+{
+#if defined(PLATFORM_WEB)
+    if (go.is_idle) emscripten_set_main_loop_timing(EM_TIMING_RAF, 1);
+#endif
+    go.is_idle = false;
+    go.drawn_in_row += 1;
+}
+
 void loop(void)
 {
     go.frame += 1;
+    go.light_recomputes_frame = 0;
+    // Frame time is stale while idle, and spans the whole wait right after
+    canvas_update(go.drawn_in_row >= 2 ? GetFrameTime() : 0.f);
+    layout_update();
+    bool animating = go.pstate.ani_time_remaining > 0.f;
+    bool changed = false;  /* Output changed outside of the game state */
+#ifdef DEBUG
+    size_t reloads = shader_stats().reloads;
+#endif
     switch (go.state) {
-        case MENU: { go.state = update_menu(); } break;
+        case MENU: {
+            go.state = update_menu();
+            if (go.state != MENU) go.menu_over = MENU;
+        } break;
         case PUZZLE_FUN: { go.state = update_puzzle(go.puzzle_fun, &go.pstate, PUZZLE_FUN); } break;
         case PUZZLE_FUN_WIN: {
             go.state = update_puzzle_win(go.puzzle_fun, &go.pstate, PUZZLE_FUN_WIN);
@@ -398,7 +541,8 @@ void loop(void)
         case FAINT: { go.state = update_sleep(&go.world, &go.sleep, &go.pstate, FAINT); } break;
     }
 
-    if (IsKeyPressed(KEY_ESCAPE) || IsKeyPressed(KEY_Q)) {
+    if ((IsKeyPressed(KEY_ESCAPE) || IsKeyPressed(KEY_Q)) && go.state != MENU) {
+        go.menu_over = go.state;
         go.state = MENU;
     }
 
@@ -410,25 +554,66 @@ void loop(void)
         free(screenshot_buf);
         INFO("Screen capture `%s` taken", screenshot_buf);
     }
+    if (IsKeyPressed(KEY_L)) {
+        go.lighting = go.lighting == LIGHTING_CPU ? LIGHTING_GPU : LIGHTING_CPU;
+        go.world->light_dirty = true;
+        INFO("Lighting backend: %s", go.lighting == LIGHTING_CPU ? "cpu" : "gpu");
+    }
+    if (IsKeyPressed(KEY_T)) {
+        go.puzzle_renderer = go.puzzle_renderer == PUZZLE_RENDER_TILEMAP ? PUZZLE_RENDER_CELLS : PUZZLE_RENDER_TILEMAP;
+        INFO("Puzzle renderer: %s", go.puzzle_renderer == PUZZLE_RENDER_TILEMAP ? "tilemap" : "cells");
+    }
+    if (IsKeyPressed(KEY_K)) {
+        shader_dump();
+    }
+    if (IsKeyPressed(KEY_V)) {
+        canvas_set_enabled(!canvas_enabled());
+        INFO("Canvas: %s", canvas_enabled() ? "on" : "off");
+    }
+    if (IsKeyPressed(KEY_F)) {
+        go.idle_skip = !go.idle_skip;
+        INFO("Idle frame skipping: %s", go.idle_skip ? "on" : "off");
+    }
+    shader_hot_reload(go.frame);
+    changed = shader_stats().reloads != reloads;
 #endif
 
+    bool dirty = !go.idle_skip || go.frame == 1 || changed || go.state != go.drawn_state || IsWindowResized()
+        || state_is_dirty(go.state, animating);
+    if (!dirty) {
+        idle_wait();
+        return;
+    }
+    idle_resume();
+    go.drawn_state = go.state;
+
 
     BeginDrawing();
 
-    ClearBackground(BLACK);
+    // Captured in a frame of its own, before this one starts recording
+    backdrop_update(go.state);
+    draw_frame_begin();
     switch (go.state) {
-        case MENU: { render_menu(); } break;
-        case PUZZLE_FUN: { render_puzzle(go.puzzle_fun, go.pstate, go.atlas, go.player_atlas, go.puzzle_shader); } break;
-        case PUZZLE_FUN_WIN: { render_puzzle_win(go.puzzle_fun, &go.pstate, go.atlas, go.player_atlas, go.puzzle_shader); } break;
-        case PUZZLE_TRAIN_WIN: { render_puzzle_win(go.puzzle_train, &go.pstate, go.atlas, go.player_atlas, go.puzzle_shader); } break;
-        case PUZZLE_TRAIN: { render_puzzle(go.puzzle_train, go.pstate, go.atlas, go.player_atlas, go.puzzle_shader); } break;
+        case MENU: { backdrop_draw(DARKGRAY); render_menu(); } break;
+        case PUZZLE_FUN: { render_puzzle(go.puzzle_fun, go.pstate, go.atlas, go.player_atlas, go.tilemap_shader, go.puzzle_renderer); } break;
+        case PUZZLE_FUN_WIN: { backdrop_draw(WHITE); render_puzzle_win(go.puzzle_fun); } break;
+        case PUZZLE_TRAIN_WIN: { backdrop_draw(WHITE); render_puzzle_win(go.puzzle_train); } break;
+        case PUZZLE_TRAIN: { render_puzzle(go.puzzle_train, go.pstate, go.atlas, go.player_atlas, go.tilemap_shader, go.puzzle_renderer); } break;
         case PUZZLE_BOSS_WIN: { render_victory(go.world, go.pstate, go.atlas, go.player_atlas); } break;
-        case PUZZLE_BOSS: { render_puzzle(go.puzzle_boss, go.pstate, go.atlas, go.player_atlas, go.puzzle_shader); } break;
+        case PUZZLE_BOSS: { render_puzzle(go.puzzle_boss, go.pstate, go.atlas, go.player_atlas, go.tilemap_shader, go.puzzle_renderer); } break;
         case WORLD: { render_world(go.world, go.pstate, go.world_atlas, go.player_atlas); } break;
-        case SLEEP: { render_sleep(go.world, go.sleep, go.pstate, go.world_atlas, go.player_atlas); } break;
-        case FAINT: { render_sleep(go.world, go.sleep, go.pstate, go.atlas, go.player_atlas); } break;
+        case SLEEP: { backdrop_draw(WHITE); render_sleep(go.world, go.sleep, go.pstate, go.world_atlas); } break;
+        case FAINT: { backdrop_draw(WHITE); render_sleep(go.world, go.sleep, go.pstate, go.atlas); } break;
     }
 
+#ifdef DEBUG
+    render_debug();
+#endif
+
+    // Render textures baked while recording are done, so the canvas can be bound
+    canvas_begin();
+    draw_frame_end();
+    canvas_end();
     EndDrawing();
 }
 
@@ -468,6 +653,19 @@ Color get_color_at_pos(World *w, U32x2 pos)
     return w->cell_case[pos.y * w->cols + pos.x].color;
 }
 
+Color color_of_visual(enum VisualColor color)
+{
+    switch (color) {
+        case VWHITE: { return WHITE; } break;
+        case VBLUE: { return C_BLUE; } break;
+        case VPINK: { return C_PINK; } break;
+        case VBLACK: { return BLACK; } break;
+        default: {
+            ASSERT(0, "Unreachable");
+        } break;
+    };
+}
+
 Color get_colorinfo_at_pos(World *w, U32x2 pos)
 {
     enum VisualColor color = MASK_COLOR(w->cell_case[pos.y * w->cols + pos.x].info);
@@ -538,36 +736,226 @@ Color apply_tint(Color c, u32 lightness)
 }
 
 
-void apply_lighting(World *w, PlayerState pstate)
+/**
+ * Window light quantized to TIME_LIGHT_BUCKETS steps, so the lighting cache
+ * is not invalidated by every tiny step of the clock.
+ */
+int light_bucket_from_time(PlayerState pstate)
 {
-    size_t col, row;
-    for (row = 0; row < w->rows; ++row) {
-        for (col = 0; col < w->cols; ++col) {
-            U32x2 pos = { col, row };
+    return (int) (light_from_time(pstate) / TIME_LIGHT_MAX * TIME_LIGHT_BUCKETS + 0.5f);
+}
+
+LightGrid light_grid_of_world(World *w)
+{
+    return (LightGrid) {
+        .cols = w->cols,
+        .rows = w->rows,
+        .radius = LIGHT_RADIUS,
+        .heights = w->heights,
+        .falloff = w->falloff,
+    };
+}
+
+LightSource source_of_light(Light light)
+{
+    Vector4 color = ColorNormalize(color_of_visual(light.color));
+    return (LightSource) {
+        .x = light.pos.x,
+        .y = light.pos.y,
+        .r = color.x,
+        .g = color.y,
+        .b = color.z,
+        .strength = light.strength,
+    };
+}
+
+float window_light_of_key(LightKey key)
+{
+    return key.time_bucket < 0 ? 0.f : key.time_bucket * (TIME_LIGHT_MAX / TIME_LIGHT_BUCKETS);
+}
+
+bool light_key_eq(LightKey a, LightKey b)
+{
+    return a.world_id == b.world_id && a.blinds_down == b.blinds_down && a.time_bucket == b.time_bucket;
+}
+
+/**
+ * Windows are scaled by time of day and switched off by the blinds
+ */
+float light_scale(bool is_window, LightKey key)
+{
+    if (!is_window) return 1.f;
+    if (key.blinds_down) return 0.f;
+    return window_light_of_key(key) / TIME_LIGHT_MAX;
+}
+
+void resolve_lighting(World *w, LightRect rect)
+{
+    size_t row, col;
+    for (row = rect.y0; row < rect.y1; ++row) {
+        for (col = rect.x0; col < rect.x1; ++col) {
+            size_t i = row * w->cols + col;
+            w->cell_case[i].color = light_resolve(&w->planes, i);
+        }
+    }
+}
+
+/**
+ * Sums the baked layers of the room. Rooms without an up to date bake are
+ * lit live from the light list.
+ */
+void apply_lighting(World *w, LightKey key)
+{
+    light_planes_clear(&w->planes);
+
+    if (w->bake != NULL) {
+        size_t l;
+        for (l = 0; l < w->bake->layers; ++l) {
+            float scale = light_scale(w->bake->source[l] >= 0, key);
+            if (scale == 0.f) continue;
+            light_add_layer(&w->planes, w->bake, l, scale);
+        }
+    } else {
+        size_t l;
+        for (l = 0; l < case_len(w->light_case); ++l) {
+            w->light_scales[l] = light_scale(w->light_case[l].is_window, key);
+        }
+        light_compute(&w->planes, light_grid_of_world(w), w->light_sources, w->light_scales,
+                      case_len(w->light_case), light_threads_default());
+    }
+
+    resolve_lighting(w, (LightRect) { 0, 0, w->cols, w->rows });
+}
+
+/**
+ * Brings the lighting from key old to key new by removing the old and
+ * adding the new contribution of every source whose scale changed. Only
+ * cells within LIGHT_RADIUS of those sources are touched.
+ */
+void apply_lighting_delta(World *w, LightKey old, LightKey new)
+{
+    LightGrid grid = light_grid_of_world(w);
+
+    if (w->bake != NULL) {
+        size_t l;
+        for (l = 0; l < w->bake->layers; ++l) {
+            int source = w->bake->source[l];
+            float diff = light_scale(source >= 0, new) - light_scale(source >= 0, old);
+            if (diff == 0.f) continue;
+
+            LightRect rect = source >= 0
+                ? light_rect(grid, source % w->cols, source / w->cols)
+                : (LightRect) { 0, 0, w->cols, w->rows };
+            light_add_layer_rect(&w->planes, w->bake, l, diff, rect, w->cols);
+            resolve_lighting(w, rect);
+        }
+    } else {
+        size_t l;
+        for (l = 0; l < case_len(w->light_case); ++l) {
+            Light light = w->light_case[l];
+            float diff = light_scale(light.is_window, new) - light_scale(light.is_window, old);
+            if (diff == 0.f) continue;
+
+            light_splat(&w->planes, grid, source_of_light(light), diff);
+            resolve_lighting(w, light_rect(grid, light.pos.x, light.pos.y));
+        }
+    }
+}
 
-            float b = get_brightness_at_pos(w, pos);
-            if (b == 0) continue;
-            if (get_type_at_pos(w, pos) == PWINDOW) {
-                b *= light_from_time(pstate) / TIME_LIGHT_MAX;
+/**
+ * apply_lighting for a single cell
+ */
+Color light_at_pos(World *w, U32x2 pos, LightKey key)
+{
+    size_t i = pos.y * w->cols + pos.x;
+    float acc[LIGHT_PLANES] = { 0 };
+
+    if (w->bake != NULL) {
+        size_t l, p;
+        for (l = 0; l < w->bake->layers; ++l) {
+            float scale = light_scale(w->bake->source[l] >= 0, key);
+            for (p = 0; p < LIGHT_PLANES; ++p) {
+                acc[p] += scale * w->bake->data[(l * LIGHT_PLANES + p) * w->bake->cells + i];
             }
+        }
+    } else {
+        LightGrid grid = light_grid_of_world(w);
+        size_t l;
+        for (l = 0; l < case_len(w->light_case); ++l) {
+            LightSource src = source_of_light(w->light_case[l]);
+            float k = light_weight(grid, src, pos.x, pos.y) * light_scale(w->light_case[l].is_window, key);
+            acc[0] += k * src.r;
+            acc[1] += k * src.g;
+            acc[2] += k * src.b;
+            acc[3] += k;
+        }
+    }
 
-            if (go.blinds_down && get_type_at_pos(w, pos) == PWINDOW) continue;
-
-            Color color = get_colorinfo_at_pos(w, pos);
-            int nx, ny;
-            for (nx = 0; nx < (int) w->cols; ++nx) {
-                for (ny = 0; ny < (int) w->rows; ++ny) {
-                    float val = 1.f / powf(abs((int) col - nx) + abs((int) row - ny), 2.f);
-                    if (nx == (int) col && ny == (int) row) {
-                        val = 1.f;
-                    }
-                    // inverse square law light
-                    size_t i = ny * w->cols + nx;
-                    w->cell_case[i].color = blend(w->cell_case[i].color, color, val * b);
-                }
+    LightPlanes one = { &acc[0], &acc[1], &acc[2], &acc[3], 1 };
+    return light_resolve(&one, 0);
+}
+
+LightKey light_key_of_world(World *w, PlayerState pstate)
+{
+    LightKey key = { 0 };
+    key.world_id = w->world_id;
+    key.blinds_down = go.blinds_down;
+    key.time_bucket = -1;
+
+    if (!go.blinds_down) {
+        size_t i;
+        for (i = 0; i < case_len(w->light_case); ++i) {
+            if (w->light_case[i].is_window) {
+                key.time_bucket = light_bucket_from_time(pstate);
+                break;
             }
         }
     }
+    return key;
+}
+
+/**
+ * Relights the world if any input of apply_lighting changed since last call.
+ * Changes to switchable sources are applied as deltas. After
+ * LIGHT_DELTAS_MAX deltas the planes are rebuilt to drop rounding errors.
+ */
+void update_lighting(World *w, PlayerState pstate)
+{
+    LightKey key = light_key_of_world(w, pstate);
+    if (go.lighting == LIGHTING_GPU) {
+        // Shaded in render_world_cells. Cell colors are left stale
+        w->light_key = key;
+        return;
+    }
+    if (!w->light_dirty && light_key_eq(key, w->light_key)) {
+        go.light_hits += 1;
+        return;
+    }
+
+    if (!w->light_dirty && w->light_deltas < LIGHT_DELTAS_MAX) {
+        apply_lighting_delta(w, w->light_key, key);
+        w->light_deltas += 1;
+        w->light_version += 1;
+        go.light_deltas += 1;
+    } else {
+        apply_lighting(w, key);
+        w->light_deltas = 0;
+        w->light_version += 1;
+        go.light_recomputes += 1;
+        go.light_recomputes_frame += 1;
+    }
+    w->light_key = key;
+    w->light_dirty = false;
+}
+
+/**
+ * Lights w for the time of day
+ */
+void relight_world(World *w, PlayerState *pstate)
+{
+    // Quantized like the window light, so the static layer is not rebaked every frame
+    pstate->light_tmp = light_bucket_from_time(*pstate) * (TIME_LIGHT_MAX / TIME_LIGHT_BUCKETS);
+    update_lighting(w, *pstate);
 }
 
 Sleep init_sleep(PlayerState *pstate)
@@ -650,11 +1038,13 @@ GameState update_sleep(World **w, Sleep *s, PlayerState *pstate, GameState gs)
         if (pstate->light > 0.05) {
             pstate->light -= 0.05f;
         }
+        // Lit once here, as update_world leaves it for the backdrop to freeze
+        relight_world(*w, pstate);
         return SLEEP;
     }
 
     update_world(*w, pstate);
-    pstate->time += SLEEP_SPEED * GetFrameTime();
+    pstate->time += SLEEP_SPEED * frame_time();
     if (pstate->time >= s->end_time) {
         pstate->energy = s->end_energy;
         pstate->did_faint = false;
@@ -671,38 +1061,40 @@ GameState update_sleep(World **w, Sleep *s, PlayerState *pstate, GameState gs)
 
 void render_menu(void)
 {
-    float width = GetScreenWidth();
-    float height = GetScreenHeight();
+    Layout layout = layout_get();
+    float width = layout.width;
+    float height = layout.height;
 
+    draw_set_layer(DRAW_LAYER_TEXT);
     char *msg = "Resume / play [enter]";
-    Vector2 sz = MeasureTextEx(GetFontDefault(), msg, FONT_SIZE_BIG, 4.f);
+    Vector2 sz = text_measure(msg, FONT_SIZE_BIG, 4.f);
     Vector2 pos = {
         .x = width * 0.2f,
         .y = height * 0.2f,
     };
-    DrawTextEx(GetFontDefault(), msg, pos, FONT_SIZE_BIG, 4.f, WHITE);
+    text_draw(msg, pos, FONT_SIZE_BIG, 4.f, WHITE);
 
     char *controls = "Controls:";
     Vector2 cpos = {
         .x = pos.x,
         .y = pos.y + sz.y * LINE_SPACE * LINE_SPACE,
     };
-    DrawTextEx(GetFontDefault(), controls, cpos, FONT_SIZE_BIG, 4.f, WHITE);
+    text_draw(controls, cpos, FONT_SIZE_BIG, 4.f, WHITE);
 
     char *interact = "interact        [enter]";
-    Vector2 interact_sz = MeasureTextEx(GetFontDefault(), interact, FONT_SIZE_MID, 4.f);
+    Vector2 interact_sz = text_measure(interact, FONT_SIZE_MID, 4.f);
     Vector2 interact_pos = {
         .x = pos.x,
         .y = cpos.y + sz.y * LINE_SPACE,
     };
-    DrawTextEx(GetFontDefault(), interact, interact_pos, FONT_SIZE_MID, 4.f, WHITE);
+    text_draw(interact, interact_pos, FONT_SIZE_MID, 4.f, WHITE);
 
     char *movement = "movement       [w|a|s|d]";
     Vector2 movement_pos = {
         .x = pos.x,
         .y = interact_pos.y + interact_sz.y * LINE_SPACE,
     };
-    DrawTextEx(GetFontDefault(), movement, movement_pos, FONT_SIZE_MID, 4.f, WHITE);
+    text_draw(movement, movement_pos, FONT_SIZE_MID, 4.f, WHITE);
 
 #ifdef PLATFORM_WEB
     char *modifier = "move modifier  [u]";
@@ -714,14 +1106,14 @@ void render_menu(void)
         .x = pos.x,
         .y = movement_pos.y + interact_sz.y * LINE_SPACE,
     };
-    DrawTextEx(GetFontDefault(), modifier, modifier_pos, FONT_SIZE_MID, 4.f, WHITE);
+    text_draw(modifier, modifier_pos, FONT_SIZE_MID, 4.f, WHITE);
 
     char *mirror = "puzzle: mirror [left mouse]";
     Vector2 mirror_pos = {
         .x = pos.x,
         .y = modifier_pos.y + interact_sz.y * LINE_SPACE,
     };
-    DrawTextEx(GetFontDefault(), mirror, mirror_pos, FONT_SIZE_MID, 4.f, WHITE);
+    text_draw(mirror, mirror_pos, FONT_SIZE_MID, 4.f, WHITE);
 
 #ifdef PLATFORM_WEB
     char *menu = "open menu      [q]";
@@ -732,7 +1124,7 @@ void render_menu(void)
         .x = pos.x,
         .y = mirror_pos.y + interact_sz.y * LINE_SPACE,
     };
-    DrawTextEx(GetFontDefault(), menu, menu_pos, FONT_SIZE_MID, 4.f, WHITE);
+    text_draw(menu, menu_pos, FONT_SIZE_MID, 4.f, WHITE);
 
 }
 
@@ -756,39 +1148,132 @@ GameState update_victory()
 void render_victory(World *w, PlayerState pstate, Texture2D atlas, Texture2D player_atlas)
 {
     (void) player_atlas;
+    world_layout(w);
     render_hud_lhs(pstate, w->wpos.x + w->wdim.x, atlas);
 
+    Layout layout = layout_get();
+    draw_set_layer(DRAW_LAYER_TEXT);
     char *msg = "You've made it back in the world!";
-    Vector2 sz = MeasureTextEx(GetFontDefault(), msg, FONT_SIZE_BIG, 4.f);
+    Vector2 sz = text_measure(msg, FONT_SIZE_BIG, 4.f);
     Vector2 pos = {
-        .x = (GetScreenWidth() - sz.x) / 2.f,
-        .y = 0.4f * (GetScreenHeight()),
+        .x = (layout.width - sz.x) / 2.f,
+        .y = 0.4f * layout.height,
     };
-    DrawTextEx(GetFontDefault(), msg, pos, FONT_SIZE_BIG, 4.f, WHITE);
+    text_draw(msg, pos, FONT_SIZE_BIG, 4.f, WHITE);
 
 
     char *instructions = "Thanks for playing <3";
-    Vector2 isz = MeasureTextEx(GetFontDefault(), instructions, FONT_SIZE_MID, 4.f);
+    Vector2 isz = text_measure(instructions, FONT_SIZE_MID, 4.f);
     Vector2 ipos = {
         .x = pos.x,
-        .y = 0.6f * GetScreenHeight(),
+        .y = 0.6f * layout.height,
     };
-    DrawTextEx(GetFontDefault(), instructions, ipos, FONT_SIZE_MID, 4.f, WHITE);
+    text_draw(instructions, ipos, FONT_SIZE_MID, 4.f, WHITE);
 
     char *author = "- elicatza";
     Vector2 apos = {
         .x = pos.x,
         .y = ipos.y + isz.y * 1.35f,
     };
-    DrawTextEx(GetFontDefault(), author, apos, FONT_SIZE_MID, 4.f, WHITE);
+    text_draw(author, apos, FONT_SIZE_MID, 4.f, WHITE);
+}
+
+/**
+ * Draws the scene shown under a modal state
+ */
+void render_scene(GameState state)
+{
+    switch (state) {
+        case PUZZLE_FUN:
+        case PUZZLE_FUN_WIN: { render_puzzle(go.puzzle_fun, go.pstate, go.atlas, go.player_atlas, go.tilemap_shader, go.puzzle_renderer); } break;
+        case PUZZLE_TRAIN:
+        case PUZZLE_TRAIN_WIN: { render_puzzle(go.puzzle_train, go.pstate, go.atlas, go.player_atlas, go.tilemap_shader, go.puzzle_renderer); } break;
+        case PUZZLE_BOSS: { render_puzzle(go.puzzle_boss, go.pstate, go.atlas, go.player_atlas, go.tilemap_shader, go.puzzle_renderer); } break;
+        case WORLD: { render_world(go.world, go.pstate, go.world_atlas, go.player_atlas); } break;
+        case SLEEP: { render_world_scene(go.world, go.pstate, go.world_atlas, go.player_atlas); } break;
+        case FAINT: { render_world_scene(go.world, go.pstate, go.atlas, go.player_atlas); } break;
+        case MENU: { if (go.menu_over != MENU) render_scene(go.menu_over); } break;
+        case PUZZLE_BOSS_WIN: break;
+    }
+}
+
+bool is_modal(GameState state)
+{
+    switch (state) {
+        case PUZZLE_FUN_WIN:
+        case PUZZLE_TRAIN_WIN:
+        case SLEEP:
+        case FAINT: { return true; } break;
+        case MENU: { return go.menu_over != MENU && go.menu_over != PUZZLE_BOSS_WIN; } break;
+        default: { return false; } break;
+    }
+}
+
+/**
+ * Captures the scene under state into the backdrop, unless it already holds
+ * it. Must be called outside of a recorded frame
+ */
+void backdrop_update(GameState state)
+{
+    Backdrop *b = &go.backdrop;
+    if (!is_modal(state)) {
+        b->valid = false;
+        return;
+    }
+
+    int width = canvas_width();
+    int height = canvas_height();
+    if (b->valid && b->state == state && b->target.texture.width == width && b->target.texture.height == height) {
+        go.backdrop_frames += 1;
+        return;
+    }
+    if (b->target.id != 0 && (b->target.texture.width != width || b->target.texture.height != height)) {
+        UnloadRenderTexture(b->target);
+        b->target.id = 0;
+    }
+    if (b->target.id == 0) {
+        b->target = LoadRenderTexture(width, height);
+    }
+
+    draw_frame_begin();
+    render_scene(state);
+    BeginTextureMode(b->target);
+    ClearBackground(BLACK);
+    draw_frame_end();
+    EndTextureMode();
+
+    b->state = state;
+    b->valid = true;
+    go.backdrop_captures += 1;
+}
+
+void backdrop_draw(Color tint)
+{
+    if (!go.backdrop.valid) return;
+    draw_set_layer(DRAW_LAYER_BACKDROP);
+    // Render textures are stored upside down
+    Texture2D tex = go.backdrop.target.texture;
+    draw_texture_rec(tex, (Rectangle) { 0.f, 0.f, tex.width, -tex.height }, (Vector2) { 0.f, 0.f }, tint);
+}
+
+void backdrop_free(void)
+{
+    if (go.backdrop.target.id != 0) UnloadRenderTexture(go.backdrop.target);
+    go.backdrop = (Backdrop) { 0 };
 }
 
 
-void render_sleep(World *w, Sleep s, PlayerState pstate, Texture2D atlas, Texture2D player_atlas)
+/**
+ * Hud and overlay. The world under them is the backdrop of the state
+ */
+void render_sleep(World *w, Sleep s, PlayerState pstate, Texture2D atlas)
 {
     (void) s;
-    render_world(w, pstate, atlas, player_atlas);
+    world_layout(w);
+    render_hud_rhs(pstate, w->wpos.x + w->wdim.x, atlas);
+    render_hud_lhs(pstate, w->wpos.x + w->wdim.x, atlas);
 
+    draw_set_layer(DRAW_LAYER_OVERLAY);
     Color bg = BLACK;
     bg.a = 128;
     Rectangle border = {
@@ -797,39 +1282,59 @@ void render_sleep(World *w, Sleep s, PlayerState pstate, Texture2D atlas, Textur
         .width = (1.f - 0.4f) * w->wdim.x,
         .height = (1.f - 0.4f) * w->wdim.y,
     };
-    DrawRectangleRec(border, bg);
-    DrawRectangleLinesEx(border, 5.f, BLACK);
+    draw_rectangle_rec(border, bg);
+    draw_rectangle_lines_ex(border, 5.f, BLACK);
 
+    draw_set_layer(DRAW_LAYER_TEXT);
     char *msg = pstate.did_faint ? "Fainted" : "Sleeping";
-    Vector2 sz = MeasureTextEx(GetFontDefault(), msg, w->wdim.y / 10.f, 4.f);
+    Vector2 sz = text_measure(msg, w->wdim.y / 10.f, 4.f);
     Vector2 pos = {
         .x = w->wpos.x + 0.5f * (w->wdim.x  - sz.x),
         .y = w->wpos.y + 0.3f * (w->wdim.y - sz.y),
     };
-    DrawTextEx(GetFontDefault(), msg, pos, w->wdim.x / 10.f, 4.f, WHITE);
+    text_draw(msg, pos, w->wdim.x / 10.f, 4.f, WHITE);
 
 
     char time[6];
     format_time(pstate, time, sizeof time);
-    Vector2 tsz = MeasureTextEx(GetFontDefault(), time, w->wdim.y / 10.f, 4.f);
+    Vector2 tsz = text_measure(time, w->wdim.y / 10.f, 4.f);
     Vector2 tpos = {
         .x = w->wpos.x + 0.5f * (w->wdim.x  - tsz.x),
         .y = w->wpos.y + 0.3f * (w->wdim.y - tsz.y) + sz.y,
     };
-    DrawTextEx(GetFontDefault(), time, tpos, w->wdim.x / 10.f, 4.f, WHITE);
+    text_draw(time, tpos, w->wdim.x / 10.f, 4.f, WHITE);
     
 
     char *instructions = pstate.did_faint ? "Darkness" : "Good";
-    Vector2 isz = MeasureTextEx(GetFontDefault(), instructions, w->wdim.y / 20.f, 2.f);
+    Vector2 isz = text_measure(instructions, w->wdim.y / 20.f, 2.f);
     Vector2 ipos = {
         .x = w->wpos.x + 0.5f * (w->wdim.x  - isz.x),
         .y = w->wpos.y + 0.3f * (w->wdim.y - isz.y) + sz.y + tsz.y,
     };
-    DrawTextEx(GetFontDefault(), instructions, ipos, w->wdim.y / 20.f, 4.f, WHITE);
+    text_draw(instructions, ipos, w->wdim.y / 20.f, 4.f, WHITE);
+}
+
+/**
+ * Fits the room to the canvas, once per layout
+ */
+void world_layout(World *w)
+{
+    Layout layout = layout_get();
+    if (w->layout_version == layout.version) return;
+
+    float width = layout.width;
+    float height = layout.height;
+    w->cell_width = MIN(width / w->cols, height / w->rows);
+    w->wpos.x = (width - (w->cell_width * w->cols)) / 2.f;
+    w->wpos.y = (height - (w->cell_width * w->rows)) / 2.f;
+    w->wdim.x = w->cell_width * w->cols;
+    w->wdim.y = w->cell_width * w->rows;
+    w->layout_version = layout.version;
 }
 
 GameState update_world(World *w, PlayerState *pstate)
 {
+    world_layout(w);
     Player new_p = w->player;
     Direction dir = NONE;
     if ((IsKeyPressed(KEY_W) || IsKeyPressed(KEY_UP)) && !pstate->is_sleeping) {
@@ -909,17 +1414,25 @@ GameState update_world(World *w, PlayerState *pstate)
         }
     }
 
-    size_t i;
-    for (i = 0; i < case_len(w->cell_case); ++i) {
-        w->cell_case[i].color = BLACK;
-    }
     update_pstate(pstate);
-    pstate->light_tmp = 0;
-    pstate->light_tmp += light_from_time(*pstate);
-    apply_lighting(w, *pstate);
+    if (pstate->is_sleeping || pstate->did_faint) {
+        // Frozen in the backdrop of the sleep state, and relit once awake
+        return WORLD;
+    }
+    relight_world(w, pstate);
     return WORLD;
 }
 
+/**
+ * Final color of a lit cell. Cell color holds the cached lighting and is
+ * never written by render functions
+ */
+Color cell_display_color(Cell cell, PlayerState pstate)
+{
+    Color color = ColorTint(WHITE, cell.color);
+    return ColorBrightness(color, MAX(pstate.light + pstate.light_tmp, 0.25f));
+}
+
 Vector2 vspos_of_ws(World *w, U32x2 ws)
 {
     Vector2 vs;
@@ -928,9 +1441,49 @@ Vector2 vspos_of_ws(World *w, U32x2 ws)
     return vs;
 }
 
-void render_world_cells(World *w, PlayerState pstate, Texture2D atlas)
+/**
+ * Uploads the active lights of the world to world_fs
+ */
+void set_world_shader_values(World *w, PlayerState pstate, ShaderProgram *shader)
+{
+    Vector4 lights[WORLD_LIGHTS_MAX];
+    Vector4 colors[WORLD_LIGHTS_MAX];
+    int count = 0;
+
+    size_t l;
+    for (l = 0; l < case_len(w->light_case) && count < WORLD_LIGHTS_MAX; ++l) {
+        Light light = w->light_case[l];
+        float b = light.strength * light_scale(light.is_window, w->light_key);
+        if (b == 0.f) continue;
+        lights[count] = (Vector4) { light.pos.x, light.pos.y, b, 0.f };
+        colors[count] = ColorNormalize(color_of_visual(light.color));
+        ++count;
+    }
+
+    float screen_height = layout_get().height;
+    float radius = LIGHT_RADIUS;
+    float brightness = MIN(MAX(pstate.light + pstate.light_tmp, 0.25f), 1.f);  /* As ColorBrightness */
+    shader_set(shader, "wpos", &w->wpos, SHADER_UNIFORM_VEC2);
+    shader_set(shader, "cell_width", &w->cell_width, SHADER_UNIFORM_FLOAT);
+    shader_set(shader, "screen_height", &screen_height, SHADER_UNIFORM_FLOAT);
+    shader_set(shader, "brightness", &brightness, SHADER_UNIFORM_FLOAT);
+    shader_set(shader, "radius", &radius, SHADER_UNIFORM_FLOAT);
+    shader_set(shader, "light_count", &count, SHADER_UNIFORM_INT);
+    shader_set_v(shader, "lights", lights, SHADER_UNIFORM_VEC4, count);
+    shader_set_v(shader, "light_colors", colors, SHADER_UNIFORM_VEC4, count);
+}
+
+/**
+ * Returns the number of cells drawn
+ */
+size_t render_world_cells(World *w, PlayerState pstate, Texture2D atlas)
 {
-    (void) atlas;
+    size_t draws = 0;
+    if (go.lighting == LIGHTING_GPU) {
+        set_world_shader_values(w, pstate, go.world_shader);
+        draw_begin_shader(go.world_shader->shader);
+    }
+
     size_t i;
     for (i = 0; i < case_len(w->cell_case); ++i) {
         Cell cell = w->cell_case[i];
@@ -950,7 +1503,6 @@ void render_world_cells(World *w, PlayerState pstate, Texture2D atlas)
         };
         Vector2 center = { 0.f, 0.f };
 
-        Color color = WHITE;
         float rotation = 0.f;
         switch ((enum PhysicalType) MASK_PHYSICAL_T(cell.info)) {
             case (PEMPTY): { continue; } break;
@@ -972,10 +1524,9 @@ void render_world_cells(World *w, PlayerState pstate, Texture2D atlas)
 
         // color = apply_shade(color, 0.4f);
         // color = blend(color, cell.color, 0.5);
-        color = ColorTint(color, cell.color);
-        color = ColorBrightness(color, MAX(pstate.light + pstate.light_tmp, 0.25f));
-        w->cell_case[i].color = color;
-        DrawTexturePro(atlas, src, dest, center, rotation, color); // Draw a part of a texture defined by a rectangle with 'pro' parameters
+        Color color = go.lighting == LIGHTING_GPU ? WHITE : cell_display_color(cell, pstate);
+        draw_texture_pro(atlas, src, dest, center, rotation, color); // Draw a part of a texture defined by a rectangle with 'pro' parameters
+        draws += 1;
         // cell.lighting = 0.5 + (lightness / 30.f);
         // color = blend(color, C_BLUE, cell.lighting + 5);
         // color = apply_tint(color, cell.lighting);
@@ -984,6 +1535,72 @@ void render_world_cells(World *w, PlayerState pstate, Texture2D atlas)
 
         // DrawRectangleV(vspos, dim, color);
     }
+
+    if (go.lighting == LIGHTING_GPU) {
+        draw_end_shader();
+    }
+    return draws;
+}
+
+bool layer_key_eq(LayerKey a, LayerKey b)
+{
+    return a.light_version == b.light_version && a.blinds_down == b.blinds_down
+        && a.brightness == b.brightness && a.cell_width == b.cell_width
+        && a.width == b.width && a.height == b.height && a.atlas_id == b.atlas_id;
+}
+
+/**
+ * Draws the cells from the static layer of the world, redrawing the layer
+ * first if anything it depends on changed. world_fs shades in screen space,
+ * so the gpu backend draws the cells directly.
+ */
+void render_world_layer(World *w, PlayerState pstate, Texture2D atlas)
+{
+    draw_set_layer(DRAW_LAYER_BOARD);
+    if (go.lighting == LIGHTING_GPU) {
+        render_world_cells(w, pstate, atlas);
+        return;
+    }
+
+    LayerKey key = {
+        .light_version = w->light_version,
+        .blinds_down = go.blinds_down,
+        .brightness = pstate.light + pstate.light_tmp,
+        .cell_width = w->cell_width,
+        .width = (int) ceilf(w->wdim.x),
+        .height = (int) ceilf(w->wdim.y),
+        .atlas_id = atlas.id,
+    };
+
+    if (w->layer.id == 0 || !layer_key_eq(key, w->layer_key)) {
+        if (w->layer.id != 0 && (key.width != w->layer_key.width || key.height != w->layer_key.height)) {
+            UnloadRenderTexture(w->layer);
+            w->layer.id = 0;
+        }
+        if (w->layer.id == 0) {
+            w->layer = LoadRenderTexture(key.width, key.height);
+        }
+
+        // Cells are drawn relative to the layer, not the screen
+        Vector2 wpos = w->wpos;
+        w->wpos = (Vector2) { 0.f, 0.f };
+        bool recording = draw_suspend();
+        BeginTextureMode(w->layer);
+        ClearBackground(BLANK);
+        w->layer_draws = render_world_cells(w, pstate, atlas);
+        EndTextureMode();
+        draw_resume(recording);
+        w->wpos = wpos;
+
+        w->layer_key = key;
+        go.layer_bakes += 1;
+    } else if (w->layer_draws > 0) {
+        go.layer_draws_saved += w->layer_draws - 1;
+    }
+
+    // Render textures are stored upside down
+    Rectangle src = { 0.f, 0.f, w->layer.texture.width, -w->layer.texture.height };
+    draw_texture_rec(w->layer.texture, src, w->wpos, WHITE);
 }
 
 // RLAPI Color Fade(Color color, float alpha);                                 // Get color with alpha applied, alpha goes from 0.0f to 1.0f
@@ -996,67 +1613,42 @@ void render_world_cells(World *w, PlayerState pstate, Texture2D atlas)
 
 void render_world_height_lines(World *w)
 {
-    size_t row, col;
-    float cell_width = w->wdim.x / w->cols;
-    for (row = 0; row < w->rows; ++row) {
-        for (col = 0; col < w->cols; ++col) {
-            Cell c = w->cell_case[row * w->cols + col];
-            u8 c_height = get_height_at_pos(w, (U32x2) { col, row });
-
-            if (case_len(w->cell_case) > (row + 1) * w->cols + col) {
-                // Has cell down
-                Cell cd = w->cell_case[(row + 1) * w->cols + col];
-                u8 cd_height = get_height_at_pos(w, (U32x2) { col, row + 1 });
-                if (cd.pos.x != c.pos.x) continue;
-                if (c_height != cd_height) {
-                    Vector2 start = vspos_of_ws(w, cd.pos);
-                    Vector2 end = { start.x + cell_width, start.y};
-                    float diff = fabsf((float) c_height - cd_height);
-                    DrawLineEx(start, end, diff * 2.f, BLACK);
-                }
-            }
-
-            if (case_len(w->cell_case) > row * w->cols + col + 1) {
-                // Has cell Right
-                Cell cr = w->cell_case[row * w->cols + col + 1];
-                u8 cr_height = get_height_at_pos(w, (U32x2) { col + 1, row });
-                if (cr.pos.y != c.pos.y) continue;
-                if (c_height != cr_height) {
-                    Vector2 start = vspos_of_ws(w, cr.pos);
-                    Vector2 end = { start.x, start.y + cell_width};
-                    float diff = fabsf((float) c_height - cr_height);
-                    DrawLineEx(start, end, diff * 2.f, BLACK);
-                }
-            }
-
-        }
+    height_edges_layout(&w->edges, w->wpos, w->cell_width, 2.f);
+    draw_set_layer(DRAW_LAYER_EDGES);
+    size_t i;
+    for (i = 0; i < w->edges.count; ++i) {
+        draw_rectangle_rec(w->edges.quads[i], BLACK);
     }
 }
 
 
-void render_world(World *w, PlayerState pstate, Texture2D atlas, Texture2D player_atlas)
+/**
+ * Cells and player, without the hud
+ */
+void render_world_scene(World *w, PlayerState pstate, Texture2D atlas, Texture2D player_atlas)
 {
-    float width = GetScreenWidth();
-    float height = GetScreenHeight();
-
-    w->cell_width = MIN(width / w->cols, height / w->rows);
-    w->wpos.x = (width - (w->cell_width * w->cols)) / 2.f;
-    w->wpos.y = (height - (w->cell_width * w->rows)) / 2.f;
-    w->wdim.x = w->cell_width * w->cols;
-    w->wdim.y = w->cell_width * w->rows;
-
-    render_world_cells(w, pstate, atlas);
+    world_layout(w);
+    render_world_layer(w, pstate, atlas);
     
-    Color color = get_color_at_pos(w, w->player.pos);
+    Cell player_cell = cell_at_pos(w, w->player.pos);
+    if (go.lighting == LIGHTING_GPU) {
+        player_cell.color = light_at_pos(w, w->player.pos, w->light_key);
+    }
+    Color color = cell_display_color(player_cell, pstate);
     render_player(vspos_of_ws(w, w->player.pos),
                   (Vector2) { w->cell_width, w->cell_width },
                   pstate,
                   player_atlas,
                   color);
     // render_world_height_lines(w);
+    // DrawRectangleLinesEx((Rectangle) { w->wpos.x, w->wpos.y, w->wdim.x, w->wdim.y }, 2.f, RED);
+}
+
+void render_world(World *w, PlayerState pstate, Texture2D atlas, Texture2D player_atlas)
+{
+    render_world_scene(w, pstate, atlas, player_atlas);
     render_hud_rhs(go.pstate, w->wpos.x + w->wdim.x, atlas);
     render_hud_lhs(go.pstate, w->wpos.x + w->wdim.x, atlas);
-    // DrawRectangleLinesEx((Rectangle) { w->wpos.x, w->wpos.y, w->wdim.x, w->wdim.y }, 2.f, RED);
 }
 
 void fill_world(World *w, u16 *wbody)
@@ -1074,6 +1666,53 @@ void fill_world(World *w, u16 *wbody)
     }
 }
 
+/**
+ * Collects the light sources, heights and distance falloff table used by
+ * apply_lighting, and picks up the baked light of the room
+ */
+void fill_lights(World *w)
+{
+    case_len(w->light_case) = 0;
+    size_t cells = case_len(w->cell_case);
+
+    w->heights = malloc(cells * sizeof *w->heights);
+    ASSERT(w->heights != NULL, "Malloc failed");
+    w->falloff = light_falloff_init(w->cols, w->rows, LIGHT_RADIUS);
+    light_planes_init(&w->planes, cells);
+
+    size_t i;
+    for (i = 0; i < cells; ++i) {
+        Cell cell = w->cell_case[i];
+        w->heights[i] = MASK_HEIGHT(cell.info) >> 4;
+        if (MASK_BRIGHTNESS(cell.info) == 0) continue;
+
+        Light light = {
+            .pos = cell.pos,
+            .color = MASK_COLOR(cell.info),
+            .strength = MASK_BRIGHTNESS(cell.info) >> 12,
+            .is_window = MASK_PHYSICAL_T(cell.info) == PWINDOW,
+        };
+        case_push(w->light_case, light);
+    }
+
+    size_t count = MAX(case_len(w->light_case), 1);
+    w->light_sources = malloc(count * sizeof *w->light_sources);
+    w->light_scales = malloc(count * sizeof *w->light_scales);
+    ASSERT(w->light_sources != NULL && w->light_scales != NULL, "Malloc failed");
+    for (i = 0; i < case_len(w->light_case); ++i) {
+        w->light_sources[i] = source_of_light(w->light_case[i]);
+    }
+
+    w->bake = NULL;
+    if (w->world_id < sizeof WORLD_LIGHT / sizeof *WORLD_LIGHT) {
+        const LightBake *bake = &WORLD_LIGHT[w->world_id];
+        if (bake->hash == light_hash(worlds[w->world_id], cells + 2)) {
+            w->bake = bake;
+        } else {
+            WARNING("Light bake of world %d is stale. Run `make bake`", w->world_id);
+        }
+    }
+}
 
 World *load_world(u16 world_id, u8 spawn)
 {
@@ -1087,8 +1726,16 @@ World *load_world(u16 world_id, u8 spawn)
     w->cols = cols;
     w->rows = rows;
     w->cell_case = case_init(cols * rows, sizeof *w->cell_case);
+    w->light_case = case_init(4, sizeof *w->light_case);
+    w->light_dirty = true;
+    w->light_version = 0;
+    w->layer = (RenderTexture2D) { 0 };
+    w->layer_draws = 0;
+    w->layout_version = 0;
 
     fill_world(w, wmap);
+    fill_lights(w);
+    w->edges = height_edges_init(w->heights, cols, rows);
     INFO("Spawnid %d", spawn);
     spawn_player(w, spawn);
     INFO("Player pos %d, %d", w->player.pos.x, w->player.pos.y);
@@ -1097,6 +1744,47 @@ World *load_world(u16 world_id, u8 spawn)
 
 void free_world(World *w)
 {
+    if (w->layer.id != 0) UnloadRenderTexture(w->layer);
+    light_planes_free(&w->planes);
+    height_edges_free(&w->edges);
+    free(w->light_sources);
+    free(w->light_scales);
+    free(w->heights);
+    free(w->falloff);
+    case_free(w->light_case);
+    case_free(w->cell_case);
     free(w);
 }
 
+#ifdef DEBUG
+void render_debug(void)
+{
+    draw_set_layer(DRAW_LAYER_DEBUG);
+    DrawStats stats = draw_stats();
+    draw_text(TextFormat("draw: %zu commands, %zu batches, %zu texture switches (%zu unsorted)",
+                         stats.commands, stats.batches, stats.texture_switches, stats.texture_switches_unsorted),
+              10, canvas_height() - 44, 10, GREEN);
+    size_t hits, misses;
+    text_measure_stats(&hits, &misses);
+    ShaderStats shaders = shader_stats();
+    draw_text(TextFormat("text: %zu measure hits, %zu misses | shader: %zu uploads, %zu skipped, %zu reloads",
+                         hits, misses, shaders.uploads, shaders.skipped, shaders.reloads),
+              10, canvas_height() - 56, 10, GREEN);
+    draw_text(TextFormat("light [%s]: %zu hits, %zu deltas, %zu recomputes (%zu this frame)",
+                        go.lighting == LIGHTING_CPU ? "cpu" : "gpu",
+                        go.light_hits, go.light_deltas, go.light_recomputes, go.light_recomputes_frame),
+             10, canvas_height() - 20, 10, GREEN);
+    draw_text(TextFormat("layer: %zu bakes, %zu cell draws saved | puzzle [%s]",
+                        go.layer_bakes, go.layer_draws_saved,
+                        go.puzzle_renderer == PUZZLE_RENDER_TILEMAP ? "tilemap" : "cells"),
+             10, canvas_height() - 32, 10, GREEN);
+    CanvasStats canvas = canvas_stats();
+    draw_text(TextFormat("canvas: %dx%d, scale %d of %d, upscale %d, %zu drops, %zu raises | idle [%s]: %zu skipped",
+                         canvas_width(), canvas_height(), canvas.scale, canvas.scale_max, canvas.upscale,
+                         canvas.drops, canvas.raises, go.idle_skip ? "on" : "off", go.frames_skipped),
+              10, canvas_height() - 68, 10, GREEN);
+    draw_text(TextFormat("backdrop: %zu captures, %zu frames reused", go.backdrop_captures, go.backdrop_frames),
+              10, canvas_height() - 80, 10, GREEN);
+}
+#endif
+
@@ -7,8 +7,12 @@
 
 #include "case.h"
 #include "core.h"
+#include "draw.h"
+#include "font.h"
+#include "layout.h"
 
 #define TEXTURE_BUTTON_OFFX 4.f
+#define VIGNETTE_SIZE 256  /* Texels across the falloff texture */
 
 #define M_BLUE CLITERAL(Color){ 0x55, 0xcd, 0xfc, 100 }     // Blue
 
@@ -20,79 +24,6 @@
 #define MASK_HEIGHT(a) ((a) & 0b11)
 #define MASK_TYPE(a) ((a) & 0b1100)
 
-#define MIRROR_UP (1 << 0)
-#define MIRROR_DOWN (1 << 1)
-#define MIRROR_LEFT (1 << 2)
-#define MIRROR_RIGHT (1 << 3)
-#define MIRROR_PREVIEW (1 << 4)
-
-
-
-
-/**
- * Puzzle format
- * Header: width, height, padding
- * body cell map
- */
-// static unsigned char puzzle1[] = { 
-unsigned char puzzle_fun_array[FUN_PUZZLES][19 * 19 + 3] = {
-    // { 3, 3, 50, 0, 0|P, 1|G, 0|G,3,1, 0, 0, 3, },
-    { 5, 5, 50, 0, 0, 1, 1, 1, 0,0|P,1, 1, 1, 0, 0, 3, 3, 1, 0|G, 3, 3,1|G,1, 0, 0, 3, 1, 1, },
-    { 7, 7, 50, 0, 0, 1, 1, 1, 2, 1, 0,0|P,1, 1, 1, 2, 1, 0, 0, 3, 3, 1, 2, 3, 2, 1, 3,1|G,1, 2, 2, 2|G, 0, 1, 1, 1, 2, 3, 2, 2, 3,1|G,1, 1, 0, 0, 0, 2, 1, 1, 2, 3, },
-    { 9, 9, 50, 2, 2, 2, 2, 1, 1, 0, 1, 1, 2, 2|P, 2, 1, 1, 1, 1, 0|G, 1, 2, 2, 3, 3, 1, 2, 3, 0, 1, 2, 1, 3, 1, 1, 2, 2, 2, 2, 2|G, 0, 1, 1, 1, 2, 3, 2, 2, 2, 2, 3, 1, 1, 1, 0, 3, 3, 0, 0, 2, 3, 1, 2, 3, 2, 3, 2, 1, 3, 1|G, 3, 2, 2, 0, 2, 0, 0, 1, 2, 1, 2, 1, 2, 0|G, },
-    { 11, 11, 50, 0, 0, 0, 0, 0, 3, 3, 0, 0, 0, 0, 0, 1|P, 2, 0, 3, 3, 0, 0|G, 0, 0, 0, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0|G, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 3, 3, 0, 0, 0, 0, 0, 3, 0, 0, 3, 0, 3, 0, 0, 0, 0, 3, 0|G, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 3, 3, 3, 0, 0, 0, 0, 3, 3, 0, 0, 3, 0|G, 0, 0, 0, },
-    { 13, 13, 50, 0, 0, 0, 0, 0, 3, 3, 0, 0, 0, 0, 0, 0, 0, 1|P, 2, 0, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 3, 3, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 0, 3, 3, 0, 0, 3, 3, 0, 0, 0, 3, 0, 0, 3, 0, 3|G, 0, 3, 0, 0, 0, 0, 3, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 3, 0, 0, 3, 3, 3, 0, 0, 0, 3, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 0, 3, 3, 0, 0, 3, 3, 0, 0, 3, 3, 3, 0, 0, 0, 0, 0, 0, 3|G, 0, 0, 0, 0, 3|G, 3, 0, 0, 0, 0, },
-    { 15, 15, 50, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 2, 2, 2, 1|G, 1, 2, 2|P, 2, 2, 2, 2, 2, 2, 0, 0, 2, 2|G, 2, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 2, 2, 2, 0|G, 0|G, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2|G, 2, 2, 2, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 3|G, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 0, },
-    { 17, 17, 50, 0, 3, 2, 2, 3, 3, 3, 3, 3, 2, 2, 2, 3, 3, 0, 1, 1, 0, 3, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 1, 3, 0, 3, 1|G, 0|G, 2, 2, 2, 0, 0, 2, 2, 2, 2, 2, 1, 2, 2, 2, 3, 1, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 1, 2, 0, 3, 1|G, 1, 1, 2, 2, 1, 1, 3, 3, 3, 3, 3, 1, 1, 3, 0, 0, 1, 0, 3, 3, 3, 1, 1, 1, 2, 2, 2, 2, 1, 1, 2, 0, 1, 1, 0, 3, 3, 3, 3, 1, 1, 2, 2, 2, 2, 2, 1, 2, 0, 0, 1, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 1, 2, 0, 0, 0, 0, 2, 2, 2, 1, 1, 2, 2|P, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 2, 2, 2, 1, 1, 2, 2, 2, 2, 2, 1, 1, 2, 0, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 0, 1, 1, 3, 3, 3, 3, 3, 3, 1, 1, 1, 3, 3, 3, 0, 2, 0, 1, 1|G, 3, 3, 3, 3, 3, 3, 3, 0, 1, 3, 3, 3, 0, 2, 2, 0, 3, 3, 3, 3, 2, 2, 0, 0, 3, 0, 3, 3, 3, 0, 2, 2, 0, 3, 3, 2, 2, 2, 2, 0, 0, 3, 0, 2, 2, 3, 0, 0, 2, 1, 1, 3, 3, 3, 3, 3, 0, 0, 0, 0, 2, 3, 3, 0, 0, 2, 0, 3, 3, 3, 3, 3, 2, 0, 0, 0, 0, 2, 2, 2, 0, 0, 0, },
-};
-
-unsigned char puzzle_train_array[TRAIN_PUZZLES][25 + 3] = {
-    { 5, 5, 50, 1, 1, 1, 1, 1, 1, 1 ,3, 1, 1, 1, 1, 3, 3, 1, 3, 1, 3,1|G,1, 1,1|P,3, 3, 3, },
-    { 5, 5, 50, 0, 0, 1, 1, 1, 0,0|P,1, 1, 1, 0, 0, 3, 3, 1, 3, 0, 3,1|G,1, 0, 0, 3, 1, 1, },
-    { 5, 5, 50, 1|P,1, 3, 1, 1, 3, 1, 3, 3, 3, 1, 1, 3, 1, 1, 3, 1, 3,1|G,3, 1, 1, 3, 1, 1, },
-    { 5, 5, 50, 1, 1, 3, 1, 1, 1,1|P,3, 1, 1, 1, 1, 3, 1, 1, 3, 1, 3,1|G,3, 1, 1, 3, 3, 3, },
-    { 5, 5, 50, 2, 2, 3,1|G, 2, 3, 3, 3,1|P,3, 1, 1, 3, 1, 1, 3, 3, 3, 1, 3, 1,1|G,1, 1, 1, },
-    { 5, 5, 50, 2, 2, 3, 1, 2, 3, 3, 3,1|P,3, 1, 1, 3, 1, 1, 3, 3, 3, 1, 3, 1,3|G, 3, 1, 1, },
-    { 5, 5, 50, 2,2|P,3, 1, 2, 3, 3,3|G,1, 3, 1, 1, 3, 1, 1, 3, 3, 3, 1, 2, 1,1|G,2, 2, 2, },
-    { 5, 5, 50, 1,1|P,2, 1, 2, 1, 2,3|G,1, 3, 1, 1, 3, 1, 1, 3, 3, 3, 1, 2, 1, 1, 2,2|G,2, },
-    { 5, 5, 50, 1,1|P,2, 1, 2, 1, 2,3|G,1,3|G, 1, 1, 3, 1, 1, 3, 3, 3, 1, 2, 1, 1, 2, 2, 2, },
-    { 5, 5, 50, 3,3|P,3, 3, 3, 3, 1,1|G,1, 3, 3, 1, 3, 1, 3, 3, 1, 1, 1, 3, 3, 3, 3|G, 3, 3, },
-    { 5, 5, 50, 0,0|P,0, 0, 0, 1, 1,1|G,1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 0, 0, 0|G, 0, 0, },
-    { 5, 5, 50, 3,3|P,3, 3, 3, 1, 1,1|G,1, 2, 2, 2, 2, 2, 2, 3, 3, 3,3|G,3, 0, 0, 0, 0, 0, },
-    { 5, 5, 50, 3, 3, 3, 3, 3, 1, 1,1|G,1, 2, 2,2|P,2, 2, 2, 3, 3, 3,3|G,3, 0, 0, 0, 0, 0, },
-    { 5, 5, 50, 3, 3, 3, 3, 3, 1, 1,0|G,1, 2, 2,2|P, 2, 0, 2, 3, 3, 3,0|G,3, 0, 0, 0, 0, 0, },
-    { 5, 5, 50, 3,3|P,3, 2, 3, 1, 2,2|G,2, 1, 0, 0, 1, 2, 3, 0, 1, 1,0|G,3, 3, 2, 0, 0, 0, },
-    { 5, 5, 50, 3,3|P,3, 2, 3, 1|G, 2,2,2, 1, 0, 0, 1, 2, 3, 0|G,1, 1, 0, 3|G, 3, 2, 0,0,0, },
-    { 5, 5, 50, 3, 3,3, 2, 3, 1|G, 2,2,2|G, 1, 0, 0, 1, 2, 3, 0, 1, 1, 0, 3, 3|P, 2|G, 0,0,0, },
-    { 5, 5, 50, 1, 3,3, 2, 3, 1|G, 3,2,2, 1, 0, 0, 1|P, 2|G, 3, 3, 1, 1, 1, 3, 3, 2|G, 0,2,2, },
-    { 5, 5, 50, 1, 3,3, 3|P, 3, 1|G, 3,2,2, 1, 2, 0, 2, 2, 0, 1, 1, 1, 1|G, 0, 0, 2|G, 0,2,1, },
-    { 5, 5, 50, 3, 3,3, 2|P, 3, 3|G, 3,2,2, 1, 2, 0, 2, 2, 0, 2, 3, 1, 3|G, 3, 0, 1|G, 0,2,1, },
-};
-
-unsigned char puzzle_boss[20 * 20 + 3] = {
-    20, 20, 50,
-    3, 3, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
-    3, 3, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
-    3, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0|G, 1, 
-    2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 3, 2, 1, 1, 1, 
-    2, 2, 2, 2,1|P,1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 3, 2, 1, 1, 1, 
-    2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 3, 2, 1, 1, 1, 
-    2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 3, 2, 1, 1, 1, 
-    2, 2, 1, 1, 1, 1, 1,1|G, 1, 1, 1, 2, 2, 2, 2, 2, 2, 1, 1, 1, 
-    2, 2, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 
-    2, 2, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 2, 1|G, 2, 1, 1, 1, 1, 1, 
-    2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 
-    2, 2, 0|G, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
-    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 2, 2, 
-    2, 1, 1, 1, 1, 1, 2, 2, 1, 1, 0, 0, 0, 1, 1, 2, 2, 2, 2, 2, 
-    2, 1, 1, 1, 1, 2, 2|G, 2, 2, 1, 0, 0|G, 0, 1, 2, 2, 2, 2, 2, 2, 
-    2, 2, 1, 1, 1, 1, 2, 2, 1, 1, 0, 0, 0, 1, 1, 2, 2, 2, 3, 3, 
-    2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 2, 3, 3, 
-    2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 3, 3, 
-};
-
 
 typedef enum {
     MIRROR,
@@ -112,24 +43,33 @@ typedef enum {
 } PreviewStep;
 
 typedef struct {
-    Vector2 pos;
-    PreviewStep state;
-    unsigned char height;
+    U8x2 pos;
+    u8 state;  /* PreviewStep */
+    u8 height;
 } Player;
 
+/**
+ * Position is implied by the index in cell_case
+ */
 typedef struct {
     unsigned char info;  /* Texture offset for height  */
-    Vector2 pos;           /* Stored in world space (ws) */
 } Cell;
 
 typedef struct Puzzle {
     Player *player_case;
     size_t rows;
     size_t cols;
+    u8 *occupancy;  /* 1 for every cell a player or preview stands on */
+    size_t goals;
+    size_t goals_covered;  /* Goal cells with a player on them */
 
     Cell *cell_case;
+    Texture2D tilemap;  /* info byte of every cell, for PUZZLE_RENDER_TILEMAP. id 0 until rendered */
+    HeightEdges edges;
     Button *button_case;
-    Rectangle rec;
+    Rectangle rec;  /* Set by puzzle_layout */
+    float cell_width;
+    size_t layout_version;  /* Of the layout rec was computed for */
     float padding;
     int clicked_button;  /* id if button is clicked. Else -1 */
     int hover_button;  /* id of hovered button. Else -1 */
@@ -160,12 +100,11 @@ Vector2 vec2d_sub(Vector2 a, Vector2 b)
 /**
  * Converts from position in world space to position in view space
  */
-Vector2 vs_pos_of_ws(Puzzle *p, Vector2 pos)
+Vector2 vs_pos_of_ws(Puzzle *p, U8x2 pos)
 {
-    float cell_width = p->rec.width / p->cols;
     return (Vector2) {
-        .x = pos.x * cell_width + p->rec.x,
-        .y = pos.y * cell_width + p->rec.y,
+        .x = pos.x * p->cell_width + p->rec.x,
+        .y = pos.y * p->cell_width + p->rec.y,
     };
 }
 
@@ -174,78 +113,97 @@ Vector2 vs_pos_of_ws(Puzzle *p, Vector2 pos)
  */
 Button vs_button_of_ws(Puzzle *p, Button btn)
 {
-    float cell_width = p->rec.width / p->cols;
     Button rt = btn;
-    rt.center.x = btn.center.x * cell_width + p->rec.x;
-    rt.center.y = btn.center.y * cell_width + p->rec.y;
-    rt.radius = btn.radius * cell_width;
+    rt.center.x = btn.center.x * p->cell_width + p->rec.x;
+    rt.center.y = btn.center.y * p->cell_width + p->rec.y;
+    rt.radius = btn.radius * p->cell_width;
     return rt;
 }
 
 /**
- * Converts from cell in world space to cell in view space
+ * Index of the cell at pos, which must be on the board
  */
-Cell vs_cell_of_ws(Puzzle *p, Cell cell)
+size_t cell_index_of_pos(Puzzle *p, U8x2 pos)
 {
-    Cell rt = cell;
-    rt.pos = vs_pos_of_ws(p, rt.pos);
-    return rt;
+    return pos.y * p->cols + pos.x;
+}
+
+U8x2 cell_pos_of_index(Puzzle *p, size_t i)
+{
+    return (U8x2) { i % p->cols, i / p->cols };
+}
+
+int cell_height_at_pos(Puzzle *p, U8x2 pos)
+{
+    return MASK_HEIGHT(p->cell_case[cell_index_of_pos(p, pos)].info);
 }
 
 /**
- * Converts from player in world space to player in view space
+ * Marks the cell at pos as taken or free, keeping goals_covered in step
  */
-Player vs_player_of_ws(Puzzle *p, Player player)
+void set_occupied(Puzzle *p, U8x2 pos, bool occupied)
 {
-    Player rt = player;
-    rt.pos = vs_pos_of_ws(p, rt.pos);
-    return rt;
+    size_t i = cell_index_of_pos(p, pos);
+    ASSERT(p->occupancy[i] != occupied, "Cell %zu is already %s", i, occupied ? "taken" : "free");
+    p->occupancy[i] = occupied;
+    if (MASK_TYPE(p->cell_case[i].info) == G) {
+        p->goals_covered = occupied ? p->goals_covered + 1 : p->goals_covered - 1;
+    }
 }
 
-int cell_height_at_pos(Puzzle *p, Vector2 pos)
+void push_player(Puzzle *p, Player player)
 {
-    return MASK_HEIGHT(p->cell_case[((int) (pos.y + 0.5f)) * p->cols + (int) (pos.x + 0.5f)].info);
+    set_occupied(p, player.pos, true);
+    case_push(p->player_case, player);
 }
 
 /**
- * O(n) where n is the amount of players
+ * Previews are pushed by update_puzzle and live until its next call
  */
-bool is_valid_pos(Puzzle *p, Player player)
+void clear_previews(Puzzle *p)
 {
-    Vector2 pos = player.pos;
-    if (!(pos.x >= 0 && pos.x < p->cols)) { return false; }
-    if (!(pos.y >= 0 && pos.y < p->rows)) { return false; }
-    if (cell_height_at_pos(p, pos) > player.height) { return false; }
-
     size_t i;
     for (i = 0; i < case_len(p->player_case); ++i) {
-        if ((int) pos.x + 0.5f == (int) p->player_case[i].pos.x + 0.5f &&
-            (int) pos.y + 0.5f == (int) p->player_case[i].pos.y + 0.5f) {
-            // Colliding with other object
-            return false;
-        }
+        if (p->player_case[i].state == PREVIEW) break;
+    }
+    size_t len = i;
+    for (; i < case_len(p->player_case); ++i) {
+        set_occupied(p, p->player_case[i].pos, false);
     }
-    return true;
+    case_len(p->player_case) = len;
+}
+
+/**
+ * Whether a player of height can step onto x, y, which may be off the board
+ */
+bool is_valid_pos(Puzzle *p, int x, int y, u8 height)
+{
+    if (!(x >= 0 && x < (int) p->cols)) { return false; }
+    if (!(y >= 0 && y < (int) p->rows)) { return false; }
+    size_t i = y * p->cols + x;
+    if (MASK_HEIGHT(p->cell_case[i].info) > height) { return false; }
+    // Colliding with other object
+    return !p->occupancy[i];
 }
 
 int players_cmp_ud(const void *a, const void *b)
 {
-    return ((Player *) a)->pos.y - ((Player *) b)->pos.y;
+    return (int) ((Player *) a)->pos.y - (int) ((Player *) b)->pos.y;
 }
 
 int players_cmp_du(const void *a, const void *b)
 {
-    return ((Player *) b)->pos.y - ((Player *) a)->pos.y;
+    return (int) ((Player *) b)->pos.y - (int) ((Player *) a)->pos.y;
 }
 
 int players_cmp_lr(const void *a, const void *b)
 {
-    return ((Player *) a)->pos.x - ((Player *) b)->pos.x;
+    return (int) ((Player *) a)->pos.x - (int) ((Player *) b)->pos.x;
 }
 
 int players_cmp_rl(const void *a, const void *b)
 {
-    return ((Player *) b)->pos.x - ((Player *) a)->pos.x;
+    return (int) ((Player *) b)->pos.x - (int) ((Player *) a)->pos.x;
 }
 
 /**
@@ -303,47 +261,43 @@ int mirror_over_line(Puzzle *p, int button_id, int options, PlayerState *pstate)
     size_t len = case_len(p->player_case);
     size_t i;
 
+    // Buttons sit on grid lines
+    int line_x = ws_btn.center.x;
+    int line_y = ws_btn.center.y;
+
     for (i = 0; i < len; ++i) {
 
-        Vector2 mirrored = { 0 };
+        int x = p->player_case[i].pos.x;
+        int y = p->player_case[i].pos.y;
         if (options & MIRROR_UP || options & MIRROR_DOWN) {
             // Horizontal mirror
-            mirrored = (Vector2) {
-                .x = p->player_case[i].pos.x,
-                .y = (2 * ws_btn.center.y) - p->player_case[i].pos.y - 1,
-            };
-            if ((mirrored.y >= ws_btn.center.y && options & MIRROR_UP) ||
-                (mirrored.y < ws_btn.center.y && options & MIRROR_DOWN)) {
+            y = 2 * line_y - y - 1;
+            if ((y >= line_y && options & MIRROR_UP) ||
+                (y < line_y && options & MIRROR_DOWN)) {
                 continue;
             }
         } else if (options & MIRROR_RIGHT || options & MIRROR_LEFT) {
             // Vertical mirror
-            mirrored = (Vector2) {
-                .x = (2 * ws_btn.center.x) - p->player_case[i].pos.x - 1,
-                .y = p->player_case[i].pos.y,
-            };
-            if ((mirrored.x >= ws_btn.center.x && options & MIRROR_LEFT) ||
-                (mirrored.x < ws_btn.center.x && options & MIRROR_RIGHT)) {
+            x = 2 * line_x - x - 1;
+            if ((x >= line_x && options & MIRROR_LEFT) ||
+                (x < line_x && options & MIRROR_RIGHT)) {
                 continue;
             }
         }
 
-        Player mirrored_p;
-        memcpy(&mirrored_p, &p->player_case[i], sizeof mirrored_p);
-        mirrored_p.pos = mirrored;
-
-        if (is_valid_pos(p, mirrored_p)) {
+        if (is_valid_pos(p, x, y, p->player_case[i].height)) {
+            Player mirrored_p = p->player_case[i];
+            mirrored_p.pos = (U8x2) { x, y };
             mirrored_p.height = cell_height_at_pos(p, mirrored_p.pos);
             if (options & MIRROR_PREVIEW) {
                 mirrored_p.state = PREVIEW;
-                case_push(p->player_case, mirrored_p);
+                push_player(p, mirrored_p);
             } else {
                 // In bound of puzzle
                 apply_pain(pstate);
                 if (should_faint(*pstate)) return FAINT;
                 mirrored_p.state = PHYSICAL;
-                case_push(p->player_case, mirrored_p);
-                INFO("added new at %.0f, %.0f", mirrored.x, mirrored.y);
+                push_player(p, mirrored_p);
             }
         }
     }
@@ -352,95 +306,134 @@ int mirror_over_line(Puzzle *p, int button_id, int options, PlayerState *pstate)
 
 bool is_player_at(Puzzle *p, int x, int y)
 {
+    return p->occupancy[y * p->cols + x];
+}
+
+/**
+ * Height of the player at x, y, or -1 if there is none
+ */
+int puzzle_player_height_at(Puzzle *p, int x, int y)
+{
+    if (!is_player_at(p, x, y)) return -1;
     size_t i;
     for (i = 0; i < case_len(p->player_case); ++i) {
-        Player player = p->player_case[i];
-        int playerx = (int) player.pos.x + 0.5f;
-        int playery = (int) player.pos.y + 0.5f;
-        if (playerx == x && playery == y) {
-            return true;
+        if (p->player_case[i].pos.x == x && p->player_case[i].pos.y == y) {
+            return p->player_case[i].height;
         }
     }
-    return false;
+    ASSERT(0, "Occupied cell without player");
+    return -1;
 }
 
 bool puzzle_is_finished(Puzzle *p)
 {
+    return p->goals_covered == p->goals;
+}
+
+/**
+ * Places the board in view space, once per layout. Cells are whole pixels
+ */
+void puzzle_layout(Puzzle *p)
+{
+    Layout layout = layout_get();
+    if (p->layout_version == layout.version) return;
+
+    int height = layout.height - p->padding;
+    int width = layout.width - p->padding;
+    ASSERT(width >= height);
+
+    float cell_width = MIN(width / p->cols, height / p->rows);
+    p->cell_width = cell_width;
+    p->rec.x = (width - (cell_width * p->cols)) / 2.f + p->padding / 2.f;
+    p->rec.y = (height - (cell_width * p->rows)) / 2.f + p->padding / 2.f;
+    p->rec.width = cell_width * p->cols;
+    p->rec.height = cell_width * p->rows;
+    p->layout_version = layout.version;
+}
+
+/**
+ * Steps every player one cell in dir, front most first. Rolling lets them
+ * climb one height, at an energy cost if any of them moved
+ * Returns FAINT if the player faints, else -1
+ */
+int puzzle_move(Puzzle *p, Direction dir, bool roll, PlayerState *pstate)
+{
+    __compar_fn_t cmp_fn = NULL;
+    switch (dir) {
+        case UP: { cmp_fn = players_cmp_ud; } break;
+        case DOWN: { cmp_fn = players_cmp_du; } break;
+        case LEFT: { cmp_fn = players_cmp_lr; } break;
+        case RIGHT: { cmp_fn = players_cmp_rl; } break;
+        default: {
+            ASSERT(0, "Unreachable");
+        } break;
+    };
+
+    bool found_valid = false;
+    qsort(p->player_case, case_len(p->player_case), sizeof *(p->player_case), cmp_fn);
     size_t i;
-    for (i = 0; i < case_len(p->cell_case); ++i) {
-        Cell c = p->cell_case[i];
-        if (MASK_TYPE(c.info) == G) {
-            int x = i % p->cols;
-            int y = i / p->cols;
-            if (!is_player_at(p, x, y)) {
-                return false;
+    for (i = 0; i < case_len(p->player_case); ++i) {
+        Player new_player = p->player_case[i];
+        int x = new_player.pos.x;
+        int y = new_player.pos.y;
+        switch (dir) {
+            case UP: { y += -1; } break;
+            case DOWN: { y += 1; } break;
+            case LEFT: { x += -1; } break;
+            case RIGHT: { x += 1; } break;
+            default: {
+                ASSERT(0, "Unreachable");
+            } break;
+        };
+
+        if (roll) {
+            new_player.height += 1;
+        }
+        // Check collisions
+        if (is_valid_pos(p, x, y, new_player.height)) {
+            new_player.pos = (U8x2) { x, y };
+            if (found_valid == false && roll) found_valid = true;
+            if (roll) {
+                pstate->face_id = new_face_id(pstate->face_id, dir);
+                if (pstate->energy < 0) {
+                    pstate->energy = 0.f;
+                    return FAINT;
+                }
             }
+            new_player.height = cell_height_at_pos(p, new_player.pos);
+            set_occupied(p, p->player_case[i].pos, false);
+            set_occupied(p, new_player.pos, true);
+            memcpy(&p->player_case[i], &new_player, sizeof new_player);
         }
     }
-    INFO("YOUVE WON THE GAME");
-    return true;
+    if (found_valid) {
+        apply_energy_loss(pstate);
+        if (should_faint(*pstate)) return FAINT;
+    }
+    return -1;
 }
 
 GameState update_puzzle(Puzzle *p, PlayerState *pstate, GameState default_rv)
 {
-    Direction dir;
-    __compar_fn_t cmp_fn = NULL;
+    puzzle_layout(p);
+    clear_previews(p);
 
+    Direction dir;
     if (IsKeyPressed(KEY_W) || IsKeyPressed(KEY_UP)) {
         dir = UP;
-        cmp_fn = players_cmp_ud;
     } else if (IsKeyPressed(KEY_A) || IsKeyPressed(KEY_LEFT)) {
         dir = LEFT;
-        cmp_fn = players_cmp_lr;
     } else if (IsKeyPressed(KEY_S) || IsKeyPressed(KEY_DOWN)) {
         dir = DOWN;
-        cmp_fn = players_cmp_du;
     } else if (IsKeyPressed(KEY_D) || IsKeyPressed(KEY_RIGHT)) {
         dir = RIGHT;
-        cmp_fn = players_cmp_rl;
     } else {
         dir = NONE;
     }
 
     if (dir != NONE) {
-        bool found_valid = false;
-        qsort(p->player_case, case_len(p->player_case), sizeof *(p->player_case), cmp_fn);
-        size_t i;
-        for (i = 0; i < case_len(p->player_case); ++i) {
-            Player new_player = p->player_case[i];
-            switch (dir) {
-                case UP: { new_player.pos.y += -1; } break;
-                case DOWN: { new_player.pos.y += 1; } break;
-                case LEFT: { new_player.pos.x += -1; } break;
-                case RIGHT: { new_player.pos.x += 1; } break;
-                default: {
-                    ASSERT(0, "Unreachable");
-                } break;
-            };
-
-            bool penatlty = false;
-            if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT) || IsKeyDown(KEY_U)) {
-                penatlty = true;
-                new_player.height += 1;
-            }
-            // Check collisions
-            if (is_valid_pos(p, new_player)) {
-                if (found_valid == false && penatlty) found_valid = true;
-                if (penatlty) {
-                    pstate->face_id = new_face_id(pstate->face_id, dir);
-                    if (pstate->energy < 0) {
-                        pstate->energy = 0.f;
-                        return FAINT;
-                    }
-                }
-                new_player.height = cell_height_at_pos(p, new_player.pos);
-                memcpy(&p->player_case[i], &new_player, sizeof new_player);
-            }
-        }
-        if (found_valid) {
-            apply_energy_loss(pstate);
-            if (should_faint(*pstate)) return FAINT;
-        }
+        bool roll = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT) || IsKeyDown(KEY_U);
+        if (puzzle_move(p, dir, roll, pstate) == FAINT) return FAINT;
     }
 
     p->hover_button = button_hover_id(p, p->button_case);
@@ -495,6 +488,7 @@ GameState update_puzzle(Puzzle *p, PlayerState *pstate, GameState default_rv)
 void render_button(Puzzle *p, Button *btn, Texture2D atlas)
 {
     Button vs_btn = vs_button_of_ws(p, *btn);
+    draw_set_layer(DRAW_LAYER_UI);
     Rectangle src = {
         .x = 8.f * TEXTURE_BUTTON_OFFX + 0.1f, .y = 0.1f,
         .width = 7.8f, .height = 7.8f,
@@ -504,18 +498,21 @@ void render_button(Puzzle *p, Button *btn, Texture2D atlas)
         .width = vs_btn.radius * 2.f, .height = vs_btn.radius * 2.f,
     };
     if (btn->is_highlighted) {
-        DrawTexturePro(atlas, src, dest, (Vector2) { vs_btn.radius, vs_btn.radius} , 45.f, WHITE);
+        draw_texture_pro(atlas, src, dest, (Vector2) { vs_btn.radius, vs_btn.radius} , 45.f, WHITE);
         btn->is_highlighted = 0;
     } else {
-        DrawTexturePro(atlas, src, dest, (Vector2) { vs_btn.radius, vs_btn.radius} , 0.f, WHITE);
+        draw_texture_pro(atlas, src, dest, (Vector2) { vs_btn.radius, vs_btn.radius} , 0.f, WHITE);
     }
 }
 
 static Texture2D texture = { 0 };  // Load blank texture to fill on shader
 
+/**
+ * Draws the runs extracted by fill_edges. Every quad uses the same texture,
+ * so raylib batches them into a single draw call
+ */
 void render_height_lines(Puzzle *p)
 {
-    float cell_width = p->rec.width / p->cols;
     if (texture.width == 0) {
         INFO("Width ");
         Image imBlank = GenImageColor(20, 20, C_PINK);
@@ -523,66 +520,13 @@ void render_height_lines(Puzzle *p)
         UnloadImage(imBlank);
     }
 
-    size_t row, col;
-    for (row = 0; row < p->rows; ++row) {
-        for (col = 0; col < p->cols; ++col) {
-            Cell c = p->cell_case[row * p->cols + col];
-
-            if (case_len(p->cell_case) > (row + 1) * p->cols + col) {
-                // Has cell down
-                Cell cd = p->cell_case[(row + 1) * p->cols + col];
-                if (cd.pos.x != c.pos.x) continue;
-                if (MASK_HEIGHT(c.info) != MASK_HEIGHT(cd.info)) {
-                    Vector2 start = vs_pos_of_ws(p, cd.pos);
-                    Vector2 end = { start.x + cell_width, start. y};
-                    float diff = fabsf((float) MASK_HEIGHT(c.info) - MASK_HEIGHT(cd.info));
-                    // DrawTextureV(texture, start, RED);
-                    DrawTexturePro(texture,
-                                   (Rectangle) {
-                                   .x = 0.f,
-                                   .y = 0.f,
-                                   .width = end.x - start.x,
-                                   .height = 3.f * diff,
-                                   },
-                                   (Rectangle) {
-                                   .x = start.x,
-                                   .y = start.y - (1.5f * diff),
-                                   .width = end.x - start.x,
-                                   .height = diff * 3.f,
-                                   },
-                                   (Vector2) {0.f, 0.f }, 0.f, RED);
-                    // DrawLineEx(start, end, diff * 2.f, RED);
-                }
-            }
-
-            if (case_len(p->cell_case) > row * p->cols + col + 1) {
-                // Has cell Right
-                Cell cr = p->cell_case[row * p->cols + col + 1];
-                if (cr.pos.y != c.pos.y) continue;
-                if (MASK_HEIGHT(c.info) != MASK_HEIGHT(cr.info)) {
-                    Vector2 start = vs_pos_of_ws(p, cr.pos);
-                    Vector2 end = { start.x, start.y + cell_width};
-                    float diff = fabsf((float) MASK_HEIGHT(c.info) - MASK_HEIGHT(cr.info));
-                    // DrawTextureV(texture, start, RED);
-                    DrawTexturePro(texture,
-                                   (Rectangle) {
-                                   .x = 0.f,
-                                   .y = 0.f,
-                                   .width = 3.f * diff,
-                                   .height = end.y - start.y,
-                                   },
-                                   (Rectangle) {
-                                   .x = start.x - (1.5f * diff),
-                                   .y = start.y,
-                                   .width = diff * 3.f,
-                                   .height = end.y - start.y,
-                                   },
-                                   (Vector2) {0.f, 0.f }, 0.f, RED);
-                    // DrawLineEx(start, end, diff * 2.f, RED);
-                }
-            }
-
-        }
+    height_edges_layout(&p->edges, (Vector2) { p->rec.x, p->rec.y }, p->cell_width, 3.f);
+    draw_set_layer(DRAW_LAYER_EDGES);
+    size_t i;
+    for (i = 0; i < p->edges.count; ++i) {
+        Rectangle quad = p->edges.quads[i];
+        Rectangle src = { 0.f, 0.f, quad.width, quad.height };
+        draw_texture_pro(texture, src, quad, (Vector2) { 0.f, 0.f }, 0.f, RED);
     }
 }
 
@@ -612,15 +556,16 @@ void render_selection(Puzzle *p, Button sel_ws)
         rec.width = p->rec.width;
         rec.height = p->rec.y + p->rec.height - sel_vs.center.y ;
     }
-    DrawRectangleRec(rec, M_BLUE);
+    draw_set_layer(DRAW_LAYER_SELECTION);
+    draw_rectangle_rec(rec, M_BLUE);
 }
 
-void render_cell(Puzzle *p, Cell cell, Texture2D atlas)
+void render_cell(Puzzle *p, size_t i, Texture2D atlas)
 {
-    Cell vs_cell = vs_cell_of_ws(p, cell);
-    float cell_width = p->rec.width / p->cols;
+    Cell cell = p->cell_case[i];
+    Vector2 vs_pos = vs_pos_of_ws(p, cell_pos_of_index(p, i));
     Rectangle src;
-    if (MASK_TYPE(vs_cell.info) == G) {
+    if (MASK_TYPE(cell.info) == G) {
         src = (Rectangle) {
             .x = 8.f * MASK_HEIGHT(cell.info), .y = 8.f,
             .width = 8.f, .height = 8.f,
@@ -633,16 +578,17 @@ void render_cell(Puzzle *p, Cell cell, Texture2D atlas)
         };
     }
     Rectangle dest = {
-        .x = vs_cell.pos.x, .y = vs_cell.pos.y,
-        .width = cell_width, .height = cell_width,
+        .x = vs_pos.x, .y = vs_pos.y,
+        .width = p->cell_width, .height = p->cell_width,
     };
-    DrawTexturePro(atlas, src, dest, (Vector2) { 0.f, 0.f} , 0.f, WHITE);
+    draw_texture_pro(atlas, src, dest, (Vector2) { 0.f, 0.f} , 0.f, WHITE);
 }
 
 void render_puzzle_grid(Puzzle *p)
 {
+    draw_set_layer(DRAW_LAYER_GRID);
     // Draw rows
-    float cell_width = p->rec.height / p->cols;
+    float cell_width = p->cell_width;
     size_t row;
     for (row = 0; row < p->rows; ++row) {
         Vector2 start = {
@@ -653,7 +599,7 @@ void render_puzzle_grid(Puzzle *p)
             .x = p->rec.x + p->rec.width,
             .y = row * cell_width + p->rec.y,
         };
-        DrawLineEx(start, end, 1.f, BLACK);
+        draw_line_ex(start, end, 1.f, BLACK);
     }
 
     // Draw columns
@@ -667,53 +613,151 @@ void render_puzzle_grid(Puzzle *p)
             .x = col * cell_width + p->rec.x,
             .y = p->rec.y + p->rec.height,
         };
-        DrawLineEx(start, end, 1.f, BLACK);
+        draw_line_ex(start, end, 1.f, BLACK);
     }
 }
 
-void render_puzzle(Puzzle *p, PlayerState pstate, Texture2D atlas, Texture2D player_atlas, Shader fs)
+/**
+ * One grayscale texel per cell holding its info byte. Cells never change
+ * after load, so it is uploaded once, on first render so load_puzzle works
+ * without a window
+ */
+void fill_tilemap(Puzzle *p)
 {
-    int center_loc = GetShaderLocation(fs, "center");
-    Vector2 center_val = { .x = (p->rec.width / 2.f) + p->rec.x, .y = (p->rec.height / 2.f) + p->rec.y };
-    int radius_loc = GetShaderLocation(fs, "radius");
+    Image img = {
+        .data = p->cell_case,  /* Cell is just the info byte */
+        .width = p->cols,
+        .height = p->rows,
+        .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE,
+        .mipmaps = 1,
+    };
+    p->tilemap = LoadTextureFromImage(img);
+    SetTextureFilter(p->tilemap, TEXTURE_FILTER_POINT);
+}
 
-    float rad = (pstate.light + pstate.light_tmp) * 9.f + 2.f; // Shift range from [0, 1] to [2, 11]
-    float radius_val = (p->rec.width / p->cols) * rad * M_SQRT2;
+/**
+ * Uploads the board layout to the tilemap shader
+ */
+void set_tilemap_shader_values(Puzzle *p, Texture2D atlas, ShaderProgram *fs)
+{
+    Vector4 board = { p->rec.x, p->rec.y, p->rec.width, p->rec.height };
+    Vector2 dim = { p->cols, p->rows };
+    Vector2 atlas_size = { atlas.width, atlas.height };
+    Vector4 edge_color = ColorNormalize(C_PINK);  /* Color of the blank edge texture */
+    float screen_height = layout_get().height;
+    shader_set(fs, "board", &board, SHADER_UNIFORM_VEC4);
+    shader_set(fs, "dim", &dim, SHADER_UNIFORM_VEC2);
+    shader_set(fs, "atlas_size", &atlas_size, SHADER_UNIFORM_VEC2);
+    shader_set(fs, "edge_color", &edge_color, SHADER_UNIFORM_VEC4);
+    shader_set(fs, "screen_height", &screen_height, SHADER_UNIFORM_FLOAT);
+    shader_set_texture(fs, "tilemap", p->tilemap);
+}
 
-    SetShaderValue(fs, center_loc, &center_val, SHADER_UNIFORM_VEC2);
-    SetShaderValue(fs, radius_loc, &radius_val, SHADER_UNIFORM_FLOAT);
+/**
+ * Cells, grid, height lines and border in a single quad. The shader reads
+ * the cells from p->tilemap, so the draw count does not grow with the board
+ */
+void render_puzzle_tilemap(Puzzle *p, Texture2D atlas, ShaderProgram *fs)
+{
+    if (p->tilemap.id == 0) fill_tilemap(p);
+    set_tilemap_shader_values(p, atlas, fs);
+    draw_set_layer(DRAW_LAYER_BOARD);
+    draw_begin_shader(fs->shader);
+    // Binds atlas as texture0. Atlas coordinates are computed by the shader
+    Rectangle src = { 0.f, 0.f, atlas.width, atlas.height };
+    draw_texture_pro(atlas, src, p->rec, (Vector2) { 0.f, 0.f }, 0.f, WHITE);
+    draw_end_shader();
+}
 
-    int height = GetScreenHeight() - p->padding;
-    int width = GetScreenWidth() - p->padding;
-    ASSERT(width >= height);
+static Texture2D vignette = { 0 };
 
-    float cell_width = MIN(width / p->cols, height / p->rows);
-    p->rec.x = (width - (cell_width * p->cols)) / 2.f + p->padding / 2.f;
-    p->rec.y = (height - (cell_width * p->rows)) / 2.f + p->padding / 2.f;
-    p->rec.width = cell_width * p->cols;
-    p->rec.height = cell_width * p->rows;
+/**
+ * 1 - (d / r)^2 around the center, reaching 0 one texel before the border.
+ * Clamped, so everything outside the circle samples 0
+ */
+Texture2D vignette_texture(void)
+{
+    if (vignette.id != 0) return vignette;
+
+    unsigned char *texels = malloc(VIGNETTE_SIZE * VIGNETTE_SIZE);
+    ASSERT(texels != NULL, "Malloc failed");
+    float center = VIGNETTE_SIZE / 2.f;
+    float radius = center - 1.f;
+    int x, y;
+    for (y = 0; y < VIGNETTE_SIZE; ++y) {
+        for (x = 0; x < VIGNETTE_SIZE; ++x) {
+            float dx = x + 0.5f - center;
+            float dy = y + 0.5f - center;
+            float k = 1.f - (dx * dx + dy * dy) / (radius * radius);
+            texels[y * VIGNETTE_SIZE + x] = (unsigned char) (MAX(k, 0.f) * 255.f + 0.5f);
+        }
+    }
+    Image img = {
+        .data = texels,
+        .width = VIGNETTE_SIZE,
+        .height = VIGNETTE_SIZE,
+        .format = PIXELFORMAT_UNCOMPRESSED_GRAYSCALE,
+        .mipmaps = 1,
+    };
+    vignette = LoadTextureFromImage(img);
+    SetTextureFilter(vignette, TEXTURE_FILTER_BILINEAR);
+    SetTextureWrap(vignette, TEXTURE_WRAP_CLAMP);
+    free(texels);
+    return vignette;
+}
+
+/**
+ * Darkens the board towards the edge of the light circle, black outside.
+ * One multiplied quad over the board, whatever was drawn under it
+ */
+void render_vignette(Puzzle *p, PlayerState pstate)
+{
+    Texture2D tex = vignette_texture();
+    Vector2 center = { p->rec.x + p->rec.width / 2.f, p->rec.y + p->rec.height / 2.f };
+    float rad = (pstate.light + pstate.light_tmp) * 9.f + 2.f; // Shift range from [0, 1] to [2, 11]
+    float radius = p->cell_width * rad * M_SQRT2;
+
+    float scale = (VIGNETTE_SIZE / 2.f - 1.f) / radius;  /* Texels per pixel */
+    Rectangle src = {
+        .x = VIGNETTE_SIZE / 2.f + (p->rec.x - center.x) * scale,
+        .y = VIGNETTE_SIZE / 2.f + (p->rec.y - center.y) * scale,
+        .width = p->rec.width * scale,
+        .height = p->rec.height * scale,
+    };
+    draw_set_layer(DRAW_LAYER_VIGNETTE);
+    draw_begin_blend(BLEND_MULTIPLIED);
+    draw_texture_pro(tex, src, p->rec, (Vector2) { 0.f, 0.f }, 0.f, WHITE);
+    draw_end_blend();
+}
 
+void render_puzzle(Puzzle *p, PlayerState pstate, Texture2D atlas, Texture2D player_atlas, ShaderProgram *tilemap_fs, PuzzleRenderer renderer)
+{
+    puzzle_layout(p);
 
-    BeginShaderMode(fs);
-    // Draw cells
     size_t i;
-    for (i = 0; i < case_len(p->cell_case); ++i) {
-        render_cell(p, p->cell_case[i], atlas);
-    }
-    // EndShaderMode();
+    if (renderer == PUZZLE_RENDER_TILEMAP) {
+        render_puzzle_tilemap(p, atlas, tilemap_fs);
+    } else {
+        draw_set_layer(DRAW_LAYER_BOARD);
+        // Draw cells
+        for (i = 0; i < case_len(p->cell_case); ++i) {
+            render_cell(p, i, atlas);
+        }
+        // EndShaderMode();
 
 
-    render_puzzle_grid(p);
+        render_puzzle_grid(p);
 
-    render_height_lines(p);
+        render_height_lines(p);
 
-    if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT) || IsKeyDown(KEY_U)) {
-        DrawRectangleLinesEx(p->rec, 3.f, RED);
-    } else {
-        DrawRectangleLinesEx(p->rec, 3.f, GREEN);
+        draw_set_layer(DRAW_LAYER_GRID);
+        if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT) || IsKeyDown(KEY_U)) {
+            draw_rectangle_lines_ex(p->rec, 3.f, RED);
+        } else {
+            draw_rectangle_lines_ex(p->rec, 3.f, GREEN);
+        }
     }
-
-    EndShaderMode();
+    render_vignette(p, pstate);
 
     // Draws players
     for (i = 0; i < case_len(p->player_case); ++i) {
@@ -723,16 +767,11 @@ void render_puzzle(Puzzle *p, PlayerState pstate, Texture2D atlas, Texture2D pla
         }
         render_player(
             vs_pos_of_ws(p, p->player_case[i].pos), 
-            (Vector2) { p->rec.height / p->cols, p->rec.height / p->cols },
+            (Vector2) { p->cell_width, p->cell_width },
             pstate,
             player_atlas,
             color);
     }
-    for (i = 0; i < case_len(p->player_case); ++i) {
-        if (p->player_case[i].state == PREVIEW) {
-            case_len(p->player_case) = i;
-        }
-    }
     if (p->clicked_button != -1) {
         Button sel_ws = p->button_case[p->clicked_button];
         if (CheckCollisionPointRec(GetMousePosition(), p->rec)) {
@@ -749,10 +788,14 @@ void render_puzzle(Puzzle *p, PlayerState pstate, Texture2D atlas, Texture2D pla
     render_hud_lhs(pstate, p->rec.x + p->rec.width, atlas);
 }
 
-void render_puzzle_win(Puzzle *p, PlayerState *pstate, Texture2D atlas, Texture2D player_atlas, Shader fs)
+/**
+ * Overlay only. The puzzle under it is drawn once by render_puzzle, into
+ * the backdrop of the win state
+ */
+void render_puzzle_win(Puzzle *p)
 {
-    render_puzzle(p, *pstate, atlas, player_atlas, fs);
-
+    puzzle_layout(p);
+    draw_set_layer(DRAW_LAYER_OVERLAY);
     Color bg = BLACK;
     bg.a = 128;
     Rectangle border = {
@@ -761,24 +804,25 @@ void render_puzzle_win(Puzzle *p, PlayerState *pstate, Texture2D atlas, Texture2
         .width = (1.f - 0.4f) * p->rec.width,
         .height = (1.f - 0.4f) * p->rec.height,
     };
-    DrawRectangleRec(border, bg);
-    DrawRectangleLinesEx(border, 5.f, BLACK);
+    draw_rectangle_rec(border, bg);
+    draw_rectangle_lines_ex(border, 5.f, BLACK);
 
+    draw_set_layer(DRAW_LAYER_TEXT);
     char *msg = "Next!";
-    Vector2 sz = MeasureTextEx(GetFontDefault(), msg, p->rec.height / 10.f, 4.f);
+    Vector2 sz = text_measure(msg, p->rec.height / 10.f, 4.f);
     Vector2 pos = {
         .x = p->rec.x + 0.5f * (p->rec.width  - sz.x),
         .y = p->rec.y + 0.3f * (p->rec.height - sz.y),
     };
-    DrawTextEx(GetFontDefault(), msg, pos, p->rec.height / 10.f, 4.f, WHITE);
+    text_draw(msg, pos, p->rec.height / 10.f, 4.f, WHITE);
 
     char *instructions = "[enter]";
-    Vector2 isz = MeasureTextEx(GetFontDefault(), instructions, p->rec.height / 20.f, 2.f);
+    Vector2 isz = text_measure(instructions, p->rec.height / 20.f, 2.f);
     Vector2 ipos = {
         .x = p->rec.x + 0.5f * (p->rec.width  - isz.x),
         .y = p->rec.y + 0.3f * (p->rec.height - isz.y) + sz.y,
     };
-    DrawTextEx(GetFontDefault(), instructions, ipos, p->rec.height / 20.f, 4.f, WHITE);
+    text_draw(instructions, ipos, p->rec.height / 20.f, 4.f, WHITE);
 }
 
 GameState update_puzzle_win(Puzzle *p, PlayerState *pstate, GameState default_rv)
@@ -798,23 +842,34 @@ GameState update_puzzle_win(Puzzle *p, PlayerState *pstate, GameState default_rv
 void fill_cells(Puzzle *p, unsigned char *puzzle_body)
 {
     case_len(p->cell_case) = 0;
+    p->goals = 0;
 
     size_t row, col;
     for (row = 0; row < p->rows; ++row) {
         for (col = 0; col < p->cols; ++col) {
             Cell cell = {
-                .pos = (Vector2) {
-                    .x = col,
-                    .y = row,
-                },
                 .info = puzzle_body[row * p->cols + col],
             };
             case_push(p->cell_case, cell);
+            if (MASK_TYPE(cell.info) == G) p->goals += 1;
 
         }
     }
 }
 
+void fill_edges(Puzzle *p, unsigned char *puzzle_body)
+{
+    size_t cells = p->cols * p->rows;
+    u8 *heights = malloc(cells * sizeof *heights);
+    ASSERT(heights != NULL, "Malloc failed");
+    size_t i;
+    for (i = 0; i < cells; ++i) {
+        heights[i] = MASK_HEIGHT(puzzle_body[i]);
+    }
+    p->edges = height_edges_init(heights, p->cols, p->rows);
+    free(heights);
+}
+
 void fill_players(Puzzle *p, unsigned char *puzzle_body)
 {
     case_len(p->player_case) = 0;
@@ -824,14 +879,11 @@ void fill_players(Puzzle *p, unsigned char *puzzle_body)
         for (col = 0; col < p->cols; ++col) {
             if ((puzzle_body[row * p->cols + col] & 0b1100) == P) {
                 Player player = {
-                    .pos = (Vector2) {
-                        .x = col,
-                        .y = row,
-                    },
+                    .pos = (U8x2) { col, row },
                     .height = puzzle_body[row * p->cols + col],
                     .state = PHYSICAL,
                 };
-                case_push(p->player_case, player);
+                push_player(p, player);
             }
         }
     }
@@ -880,14 +932,21 @@ Puzzle *load_puzzle(unsigned char *bytes)
     Puzzle *p = malloc(sizeof *p);
     p->clicked_button = -1;
     p->hover_button = -1;
+    p->layout_version = 0;
     p->cols = bytes[0];
     p->rows = bytes[1];
     p->padding = bytes[2];
     p->cell_case = case_init(p->cols * p->rows, sizeof *p->cell_case);
-    p->player_case = case_init(64, sizeof *p->player_case);
+    // Never more players than cells
+    p->player_case = case_init(p->cols * p->rows, sizeof *p->player_case);
     p->button_case = case_init(p->cols + p->rows, sizeof *p->button_case);
+    p->occupancy = calloc(p->cols * p->rows, sizeof *p->occupancy);
+    ASSERT(p->occupancy != NULL, "Calloc failed");
+    p->goals_covered = 0;
+    p->tilemap = (Texture2D) { 0 };
 
     fill_cells(p, &bytes[3]);
+    fill_edges(p, &bytes[3]);
     fill_players(p, &bytes[3]);
     fill_buttons(p);
 
@@ -896,12 +955,23 @@ Puzzle *load_puzzle(unsigned char *bytes)
 
 void free_puzzle(Puzzle *p)
 {
+    if (p->tilemap.id != 0) UnloadTexture(p->tilemap);
+    height_edges_free(&p->edges);
     case_free(p->button_case);
     case_free(p->player_case);
     case_free(p->cell_case);
+    free(p->occupancy);
     free(p);
 }
 
+/**
+ * GPU resources shared by every puzzle, such as the vignette
+ */
+void puzzle_free_resources(void)
+{
+    if (vignette.id != 0) UnloadTexture(vignette);
+    vignette = (Texture2D) { 0 };
+}
+
 // TODO:
-// Consider adding cell_width to Puzzle object
 // Does Direction need enumeration
@@ -3,6 +3,7 @@
 
 #include <raylib.h>
 #include "core.h"
+#include "shader.h"
 
 /**
 * Used to define puzzles
@@ -11,14 +12,43 @@
 
 #define PUZZEL_BUTTON_SZ 0.25f
 
+#define MIRROR_UP (1 << 0)
+#define MIRROR_DOWN (1 << 1)
+#define MIRROR_LEFT (1 << 2)
+#define MIRROR_RIGHT (1 << 3)
+#define MIRROR_PREVIEW (1 << 4)
+
 typedef struct Puzzle Puzzle;
 
+/**
+ * Cell coordinates in world space (ws). Boards are at most 255 cells wide
+ */
+typedef struct U8x2 {
+    u8 x;
+    u8 y;
+} U8x2;
+
+typedef enum {
+    PUZZLE_RENDER_CELLS,  /* One draw per cell, grid line and height edge */
+    PUZZLE_RENDER_TILEMAP,  /* One quad drawn with tilemap_fs */
+} PuzzleRenderer;
+
 Puzzle *load_puzzle(unsigned char *bytes);
 GameState update_puzzle(Puzzle *p, PlayerState *pstate, GameState default_rv);
-void render_puzzle(Puzzle *p, PlayerState pstate, Texture2D atlas, Texture2D player_atlas, Shader fs);
+void render_puzzle(Puzzle *p, PlayerState pstate, Texture2D atlas, Texture2D player_atlas, ShaderProgram *tilemap_fs, PuzzleRenderer renderer);
 void free_puzzle(Puzzle *p);
+void puzzle_free_resources(void);
+
+/**
+ * Game rules without input or rendering, for tools. Button ids count the
+ * row buttons 1..rows-1 first, then the column buttons 1..cols-1
+ */
+int puzzle_move(Puzzle *p, Direction dir, bool roll, PlayerState *pstate);
+int mirror_over_line(Puzzle *p, int button_id, int options, PlayerState *pstate);
+bool puzzle_is_finished(Puzzle *p);
+int puzzle_player_height_at(Puzzle *p, int x, int y);
 
-void render_puzzle_win(Puzzle *p, PlayerState *pstate, Texture2D atlas, Texture2D player_atlas, Shader fs);
+void render_puzzle_win(Puzzle *p);
 GameState update_puzzle_win(Puzzle *p, PlayerState *pstate, GameState default_rv);
 
 #ifndef NO_TEMPLATE
@@ -0,0 +1,65 @@
+#include "puzzle.h"
+
+/**
+ * Puzzle format
+ * Header: width, height, padding
+ * body cell map
+ */
+// static unsigned char puzzle1[] = { 
+unsigned char puzzle_fun_array[FUN_PUZZLES][19 * 19 + 3] = {
+    // { 3, 3, 50, 0, 0|P, 1|G, 0|G,3,1, 0, 0, 3, },
+    { 5, 5, 50, 0, 0, 1, 1, 1, 0,0|P,1, 1, 1, 0, 0, 3, 3, 1, 0|G, 3, 3,1|G,1, 0, 0, 3, 1, 1, },
+    { 7, 7, 50, 0, 0, 1, 1, 1, 2, 1, 0,0|P,1, 1, 1, 2, 1, 0, 0, 3, 3, 1, 2, 3, 2, 1, 3,1|G,1, 2, 2, 2|G, 0, 1, 1, 1, 2, 3, 2, 2, 3,1|G,1, 1, 0, 0, 0, 2, 1, 1, 2, 3, },
+    { 9, 9, 50, 2, 2, 2, 2, 1, 1, 0, 1, 1, 2, 2|P, 2, 1, 1, 1, 1, 0|G, 1, 2, 2, 3, 3, 1, 2, 3, 0, 1, 2, 1, 3, 1, 1, 2, 2, 2, 2, 2|G, 0, 1, 1, 1, 2, 3, 2, 2, 2, 2, 3, 1, 1, 1, 0, 3, 3, 0, 0, 2, 3, 1, 2, 3, 2, 3, 2, 1, 3, 1|G, 3, 2, 2, 0, 2, 0, 0, 1, 2, 1, 2, 1, 2, 0|G, },
+    { 11, 11, 50, 0, 0, 0, 0, 0, 3, 3, 0, 0, 0, 0, 0, 1|P, 2, 0, 3, 3, 0, 0|G, 0, 0, 0, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0|G, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 3, 3, 0, 0, 0, 0, 0, 3, 0, 0, 3, 0, 3, 0, 0, 0, 0, 3, 0|G, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 3, 3, 3, 0, 0, 0, 0, 3, 3, 0, 0, 3, 0|G, 0, 0, 0, },
+    { 13, 13, 50, 0, 0, 0, 0, 0, 3, 3, 0, 0, 0, 0, 0, 0, 0, 1|P, 2, 0, 3, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 3, 3, 0, 0, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 0, 3, 3, 0, 0, 3, 3, 0, 0, 0, 3, 0, 0, 3, 0, 3|G, 0, 3, 0, 0, 0, 0, 3, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 0, 0, 3, 0, 0, 3, 3, 3, 0, 0, 0, 3, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 0, 3, 3, 0, 0, 3, 3, 0, 0, 3, 3, 3, 0, 0, 0, 0, 0, 0, 3|G, 0, 0, 0, 0, 3|G, 3, 0, 0, 0, 0, },
+    { 15, 15, 50, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 0, 0, 2, 2, 2, 1|G, 1, 2, 2|P, 2, 2, 2, 2, 2, 2, 0, 0, 2, 2|G, 2, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 2, 2, 2, 0|G, 0|G, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2|G, 2, 2, 2, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 3|G, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 0, },
+    { 17, 17, 50, 0, 3, 2, 2, 3, 3, 3, 3, 3, 2, 2, 2, 3, 3, 0, 1, 1, 0, 3, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 1, 3, 0, 3, 1|G, 0|G, 2, 2, 2, 0, 0, 2, 2, 2, 2, 2, 1, 2, 2, 2, 3, 1, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 1, 2, 0, 3, 1|G, 1, 1, 2, 2, 1, 1, 3, 3, 3, 3, 3, 1, 1, 3, 0, 0, 1, 0, 3, 3, 3, 1, 1, 1, 2, 2, 2, 2, 1, 1, 2, 0, 1, 1, 0, 3, 3, 3, 3, 1, 1, 2, 2, 2, 2, 2, 1, 2, 0, 0, 1, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 1, 2, 0, 0, 0, 0, 2, 2, 2, 1, 1, 2, 2|P, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 2, 2, 2, 1, 1, 2, 2, 2, 2, 2, 1, 1, 2, 0, 2, 0, 0, 3, 3, 3, 3, 3, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 0, 1, 1, 3, 3, 3, 3, 3, 3, 1, 1, 1, 3, 3, 3, 0, 2, 0, 1, 1|G, 3, 3, 3, 3, 3, 3, 3, 0, 1, 3, 3, 3, 0, 2, 2, 0, 3, 3, 3, 3, 2, 2, 0, 0, 3, 0, 3, 3, 3, 0, 2, 2, 0, 3, 3, 2, 2, 2, 2, 0, 0, 3, 0, 2, 2, 3, 0, 0, 2, 1, 1, 3, 3, 3, 3, 3, 0, 0, 0, 0, 2, 3, 3, 0, 0, 2, 0, 3, 3, 3, 3, 3, 2, 0, 0, 0, 0, 2, 2, 2, 0, 0, 0, },
+};
+
+unsigned char puzzle_train_array[TRAIN_PUZZLES][25 + 3] = {
+    { 5, 5, 50, 1, 1, 1, 1, 1, 1, 1 ,3, 1, 1, 1, 1, 3, 3, 1, 3, 1, 3,1|G,1, 1,1|P,3, 3, 3, },
+    { 5, 5, 50, 0, 0, 1, 1, 1, 0,0|P,1, 1, 1, 0, 0, 3, 3, 1, 3, 0, 3,1|G,1, 0, 0, 3, 1, 1, },
+    { 5, 5, 50, 1|P,1, 3, 1, 1, 3, 1, 3, 3, 3, 1, 1, 3, 1, 1, 3, 1, 3,1|G,3, 1, 1, 3, 1, 1, },
+    { 5, 5, 50, 1, 1, 3, 1, 1, 1,1|P,3, 1, 1, 1, 1, 3, 1, 1, 3, 1, 3,1|G,3, 1, 1, 3, 3, 3, },
+    { 5, 5, 50, 2, 2, 3,1|G, 2, 3, 3, 3,1|P,3, 1, 1, 3, 1, 1, 3, 3, 3, 1, 3, 1,1|G,1, 1, 1, },
+    { 5, 5, 50, 2, 2, 3, 1, 2, 3, 3, 3,1|P,3, 1, 1, 3, 1, 1, 3, 3, 3, 1, 3, 1,3|G, 3, 1, 1, },
+    { 5, 5, 50, 2,2|P,3, 1, 2, 3, 3,3|G,1, 3, 1, 1, 3, 1, 1, 3, 3, 3, 1, 2, 1,1|G,2, 2, 2, },
+    { 5, 5, 50, 1,1|P,2, 1, 2, 1, 2,3|G,1, 3, 1, 1, 3, 1, 1, 3, 3, 3, 1, 2, 1, 1, 2,2|G,2, },
+    { 5, 5, 50, 1,1|P,2, 1, 2, 1, 2,3|G,1,3|G, 1, 1, 3, 1, 1, 3, 3, 3, 1, 2, 1, 1, 2, 2, 2, },
+    { 5, 5, 50, 3,3|P,3, 3, 3, 3, 1,1|G,1, 3, 3, 1, 3, 1, 3, 3, 1, 1, 1, 3, 3, 3, 3|G, 3, 3, },
+    { 5, 5, 50, 0,0|P,0, 0, 0, 1, 1,1|G,1, 1, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 0, 0, 0|G, 0, 0, },
+    { 5, 5, 50, 3,3|P,3, 3, 3, 1, 1,1|G,1, 2, 2, 2, 2, 2, 2, 3, 3, 3,3|G,3, 0, 0, 0, 0, 0, },
+    { 5, 5, 50, 3, 3, 3, 3, 3, 1, 1,1|G,1, 2, 2,2|P,2, 2, 2, 3, 3, 3,3|G,3, 0, 0, 0, 0, 0, },
+    { 5, 5, 50, 3, 3, 3, 3, 3, 1, 1,0|G,1, 2, 2,2|P, 2, 0, 2, 3, 3, 3,0|G,3, 0, 0, 0, 0, 0, },
+    { 5, 5, 50, 3,3|P,3, 2, 3, 1, 2,2|G,2, 1, 0, 0, 1, 2, 3, 0, 1, 1,0|G,3, 3, 2, 0, 0, 0, },
+    { 5, 5, 50, 3,3|P,3, 2, 3, 1|G, 2,2,2, 1, 0, 0, 1, 2, 3, 0|G,1, 1, 0, 3|G, 3, 2, 0,0,0, },
+    { 5, 5, 50, 3, 3,3, 2, 3, 1|G, 2,2,2|G, 1, 0, 0, 1, 2, 3, 0, 1, 1, 0, 3, 3|P, 2|G, 0,0,0, },
+    { 5, 5, 50, 1, 3,3, 2, 3, 1|G, 3,2,2, 1, 0, 0, 1|P, 2|G, 3, 3, 1, 1, 1, 3, 3, 2|G, 0,2,2, },
+    { 5, 5, 50, 1, 3,3, 3|P, 3, 1|G, 3,2,2, 1, 2, 0, 2, 2, 0, 1, 1, 1, 1|G, 0, 0, 2|G, 0,2,1, },
+    { 5, 5, 50, 3, 3,3, 2|P, 3, 3|G, 3,2,2, 1, 2, 0, 2, 2, 0, 2, 3, 1, 3|G, 3, 0, 1|G, 0,2,1, },
+};
+
+unsigned char puzzle_boss[20 * 20 + 3] = {
+    20, 20, 50,
+    3, 3, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
+    3, 3, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
+    3, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0|G, 1, 
+    2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 3, 2, 1, 1, 1, 
+    2, 2, 2, 2,1|P,1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 3, 2, 1, 1, 1, 
+    2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 3, 3, 2, 1, 1, 1, 
+    2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 3, 2, 1, 1, 1, 
+    2, 2, 1, 1, 1, 1, 1,1|G, 1, 1, 1, 2, 2, 2, 2, 2, 2, 1, 1, 1, 
+    2, 2, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 
+    2, 2, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 2, 1|G, 2, 1, 1, 1, 1, 1, 
+    2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 
+    2, 2, 0|G, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 2, 2, 
+    2, 1, 1, 1, 1, 1, 2, 2, 1, 1, 0, 0, 0, 1, 1, 2, 2, 2, 2, 2, 
+    2, 1, 1, 1, 1, 2, 2|G, 2, 2, 1, 0, 0|G, 0, 1, 2, 2, 2, 2, 2, 2, 
+    2, 2, 1, 1, 1, 1, 2, 2, 1, 1, 0, 0, 0, 1, 1, 2, 2, 2, 3, 3, 
+    2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 1, 1, 1, 1, 1, 2, 3, 3, 
+    2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 3, 3, 
+};
@@ -0,0 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+#include "shader.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+static ShaderProgram programs[SHADERS_MAX] = { 0 };
+static size_t program_count = 0;
+static ShaderStats stats = { 0 };
+static Shader default_shader = { 0 };  /* What a failed load returns, never unloaded */
+
+/**
+ * Passes the vertex attributes through, as raylib's default vertex shader
+ * does but in the GLSL 100 of every fragment shader here
+ */
+char *shader_vs =
+	"#version 100\n"
+	"\n"
+	"// Input vertex attributes\n"
+	"attribute vec3 vertexPosition;\n"
+	"attribute vec2 vertexTexCoord;\n"
+	"attribute vec3 vertexNormal;\n"
+	"attribute vec4 vertexColor;\n"
+	"\n"
+	"// Input uniform values\n"
+	"uniform mat4 mvp;\n"
+	"\n"
+	"// Output vertex attributes (to fragment shader)\n"
+	"varying vec2 fragTexCoord;\n"
+	"varying vec4 fragColor;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"    // Send vertex attributes to fragment shader\n"
+	"    fragTexCoord = vertexTexCoord;\n"
+	"    fragColor = vertexColor;\n"
+	"\n"
+	"    // Calculate final vertex position\n"
+	"    gl_Position = mvp*vec4(vertexPosition, 1.0);\n"
+	"}\n"
+	"\n";
+
+int uniform_type_size(int type)
+{
+    switch (type) {
+        case SHADER_UNIFORM_FLOAT: return sizeof(float);
+        case SHADER_UNIFORM_VEC2: return 2 * sizeof(float);
+        case SHADER_UNIFORM_VEC3: return 3 * sizeof(float);
+        case SHADER_UNIFORM_VEC4: return 4 * sizeof(float);
+        case SHADER_UNIFORM_INT: return sizeof(int);
+        case SHADER_UNIFORM_IVEC2: return 2 * sizeof(int);
+        case SHADER_UNIFORM_IVEC3: return 3 * sizeof(int);
+        case SHADER_UNIFORM_IVEC4: return 4 * sizeof(int);
+        case SHADER_UNIFORM_SAMPLER2D: return sizeof(int);
+    }
+    ASSERT(false, "Unknown uniform type");
+    return 0;
+}
+
+/**
+ * Looks up the locations of every uniform and forgets the uploaded values,
+ * which a newly linked program does not have
+ */
+void shader_resolve(ShaderProgram *sp)
+{
+    size_t i;
+    for (i = 0; i < sp->uniform_count; ++i) {
+        ShaderUniform *u = &sp->uniforms[i];
+        u->loc = GetShaderLocation(sp->shader, u->name);
+        u->size = 0;
+        if (u->loc == -1) WARNING("Uniform `%s` not found in shader `%s`", u->name, sp->name);
+    }
+}
+
+ShaderProgram *shader_load(const char *name, const char *vs, const char *fs, const char **uniforms, size_t count)
+{
+    ASSERT(program_count < SHADERS_MAX, "Too many shaders");
+    ASSERT(count <= SHADER_UNIFORMS_MAX, "Too many uniforms");
+
+    if (program_count == 0) default_shader = LoadShaderFromMemory(NULL, NULL);
+    ShaderProgram *sp = &programs[program_count];
+    program_count += 1;
+    *sp = (ShaderProgram) {
+        .name = name,
+        .vs = vs,
+        .fs = fs,
+        .shader = LoadShaderFromMemory(vs, fs),
+        .uniform_count = count,
+    };
+    size_t i;
+    for (i = 0; i < count; ++i) {
+        sp->uniforms[i].name = uniforms[i];
+    }
+    shader_resolve(sp);
+    return sp;
+}
+
+ShaderUniform *shader_uniform(ShaderProgram *sp, const char *uniform)
+{
+    size_t i;
+    for (i = 0; i < sp->uniform_count; ++i) {
+        if (strcmp(sp->uniforms[i].name, uniform) == 0) return &sp->uniforms[i];
+    }
+    ASSERT(false, "Uniform not registered with shader_load");
+    return NULL;
+}
+
+/**
+ * As SetShaderValueV, skipped when the uniform already holds value
+ */
+void shader_set_v(ShaderProgram *sp, const char *uniform, const void *value, int type, int count)
+{
+    ShaderUniform *u = shader_uniform(sp, uniform);
+    if (u->loc == -1) return;
+
+    int size = uniform_type_size(type) * count;
+    ASSERT(size <= SHADER_VALUE_MAX, "Uniform larger than SHADER_VALUE_MAX");
+    if (u->size == size && memcmp(u->value, value, size) == 0) {
+        stats.skipped += 1;
+        return;
+    }
+
+    SetShaderValueV(sp->shader, u->loc, value, type, count);
+    memcpy(u->value, value, size);
+    u->size = size;
+    stats.uploads += 1;
+}
+
+void shader_set(ShaderProgram *sp, const char *uniform, const void *value, int type)
+{
+    shader_set_v(sp, uniform, value, type, 1);
+}
+
+/**
+ * Sets the texture bound to a sampler uniform by shader_bind_textures
+ */
+void shader_set_texture(ShaderProgram *sp, const char *uniform, Texture2D texture)
+{
+    shader_uniform(sp, uniform)->texture = texture;
+}
+
+/**
+ * Binds the sampler textures of the program of shader. Call right after
+ * BeginShaderMode
+ */
+void shader_bind_textures(Shader shader)
+{
+    size_t p;
+    for (p = 0; p < program_count; ++p) {
+        ShaderProgram *sp = &programs[p];
+        if (sp->shader.id != shader.id) continue;
+
+        size_t i;
+        for (i = 0; i < sp->uniform_count; ++i) {
+            ShaderUniform *u = &sp->uniforms[i];
+            if (u->loc != -1 && u->texture.id != 0) SetShaderValueTexture(sp->shader, u->loc, u->texture);
+        }
+        return;
+    }
+}
+
+void shader_unload_all(void)
+{
+    size_t i;
+    for (i = 0; i < program_count; ++i) {
+        UnloadShader(programs[i].shader);
+    }
+    program_count = 0;
+}
+
+ShaderStats shader_stats(void)
+{
+    return stats;
+}
+
+#ifdef DEBUG
+const char *shader_path(ShaderProgram *sp)
+{
+    return TextFormat("%s/%s.fs", SHADER_DIR, sp->name);
+}
+
+/**
+ * Writes the embedded fragment sources to SHADER_DIR, keeping files that
+ * already exist
+ */
+void shader_dump(void)
+{
+    if (!DirectoryExists(SHADER_DIR)) mkdir(SHADER_DIR, 0755);
+
+    size_t i;
+    for (i = 0; i < program_count; ++i) {
+        ShaderProgram *sp = &programs[i];
+        const char *path = shader_path(sp);
+        if (FileExists(path)) continue;
+        if (SaveFileText(path, (char *) sp->fs)) INFO("Shader source `%s` written", path);
+    }
+}
+
+/**
+ * Frees a shader that failed to load. Its id and locs may be those of the
+ * default program, which stays loaded
+ */
+void shader_discard(Shader shader)
+{
+    if (shader.id != default_shader.id) {
+        UnloadShader(shader);
+    } else if (shader.locs != default_shader.locs) {
+        MemFree(shader.locs);
+    }
+}
+
+/**
+ * Recompiles programs whose source in SHADER_DIR changed. A source that
+ * fails to compile keeps the previous program
+ */
+void shader_hot_reload(size_t frame)
+{
+    if (frame % SHADER_POLL_FRAMES != 0) return;
+
+    size_t i;
+    for (i = 0; i < program_count; ++i) {
+        ShaderProgram *sp = &programs[i];
+        const char *path = shader_path(sp);
+        if (!FileExists(path)) continue;
+        long mod_time = GetFileModTime(path);
+        if (mod_time == sp->mod_time) continue;
+        sp->mod_time = mod_time;
+
+        char *fs = LoadFileText(path);
+        if (fs == NULL) continue;
+        Shader shader = LoadShaderFromMemory(sp->vs, fs);
+        UnloadFileText(fs);
+        if (!IsShaderReady(shader) || shader.id == default_shader.id) {
+            shader_discard(shader);
+            WARNING("Shader `%s` failed to compile, keeping the previous one", path);
+            continue;
+        }
+
+        UnloadShader(sp->shader);
+        sp->shader = shader;
+        shader_resolve(sp);
+        stats.reloads += 1;
+        INFO("Shader `%s` reloaded", path);
+    }
+}
+#endif
@@ -0,0 +1,68 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <raylib.h>
+#include "core.h"
+
+/**
+ * Shader registry
+ *
+ * Every shader is compiled once from its embedded source by shader_load,
+ * which also resolves the locations of the listed uniforms. shader_set
+ * compares against the last value uploaded to each uniform and skips the
+ * upload when nothing changed.
+ *
+ * Sampler uniforms are kept with the program and bound when the draw buffer
+ * begins the shader, as raylib forgets bound textures on every batch flush.
+ *
+ * In DEBUG builds shader_hot_reload recompiles a program whenever
+ * SHADER_DIR/<name>.fs changes on disk. shader_dump writes the embedded
+ * sources there to start from.
+ */
+
+#define SHADERS_MAX 8
+#define SHADER_UNIFORMS_MAX 16
+#define SHADER_VALUE_MAX 256  /* Bytes of the largest uniform, vec4[16] */
+#define SHADER_DIR "./shaders"
+#define SHADER_POLL_FRAMES 30  /* Frames between checks for changed sources */
+
+typedef struct ShaderUniform {
+    const char *name;
+    int loc;  /* -1 when not used by the shader */
+    int size;  /* Bytes in value, 0 until the first upload */
+    unsigned char value[SHADER_VALUE_MAX];
+    Texture2D texture;  /* Bound to sampler uniforms */
+} ShaderUniform;
+
+typedef struct ShaderProgram {
+    const char *name;
+    const char *vs;  /* NULL for the raylib default */
+    const char *fs;
+    Shader shader;
+    ShaderUniform uniforms[SHADER_UNIFORMS_MAX];
+    size_t uniform_count;
+    long mod_time;  /* Of the source on disk, 0 when never loaded from it */
+} ShaderProgram;
+
+typedef struct ShaderStats {
+    size_t uploads;
+    size_t skipped;  /* Uploads of a value the uniform already had */
+    size_t reloads;
+} ShaderStats;
+
+extern char *shader_vs;
+
+ShaderProgram *shader_load(const char *name, const char *vs, const char *fs, const char **uniforms, size_t count);
+void shader_set(ShaderProgram *sp, const char *uniform, const void *value, int type);
+void shader_set_v(ShaderProgram *sp, const char *uniform, const void *value, int type, int count);
+void shader_set_texture(ShaderProgram *sp, const char *uniform, Texture2D texture);
+void shader_bind_textures(Shader shader);
+void shader_unload_all(void);
+ShaderStats shader_stats(void);
+
+#ifdef DEBUG
+void shader_dump(void);
+void shader_hot_reload(size_t frame);
+#endif
+
+#endif  /* SHADER_H */
@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "light.h"
+#include "puzzle.h"
+#include "solver.h"
+
+#define SOLVE_BENCH_NODES (1 << 20)  /* Enough for boss to give up in seconds */
+
+typedef struct SolvePuzzle {
+    char name[16];
+    unsigned char *bytes;
+} SolvePuzzle;
+
+/**
+ * Every shipped puzzle, named fun0.., train0.. and boss
+ */
+size_t solve_puzzles(SolvePuzzle *out)
+{
+    size_t len = 0;
+    size_t i;
+    for (i = 0; i < FUN_PUZZLES; ++i) {
+        snprintf(out[len].name, sizeof out[len].name, "fun%zu", i);
+        out[len++].bytes = puzzle_fun_array[i];
+    }
+    for (i = 0; i < TRAIN_PUZZLES; ++i) {
+        snprintf(out[len].name, sizeof out[len].name, "train%zu", i);
+        out[len++].bytes = puzzle_train_array[i];
+    }
+    snprintf(out[len].name, sizeof out[len].name, "boss");
+    out[len++].bytes = puzzle_boss;
+    return len;
+}
+
+/**
+ * A greedy result is marked with a ~, its cost is only an upper bound
+ */
+void solve_print(const char *name, const unsigned char *bytes, SolveResult r, bool greedy)
+{
+    printf("%-8s %2dx%-2d | ", name, bytes[0], bytes[1]);
+    if (r.solved) {
+        printf("%senergy %5.3f pain %5.3f | %3zu actions", greedy ? "~" : " ",
+               r.rolls * PENALTY_ENERGY, r.clones * PENALTY_PAIN, r.path_len);
+    } else {
+        printf(" %-36s", r.gave_up ? "gave up" : "unsolvable");
+    }
+    printf(" | %9zu states | %8.3f s\n", r.explored, r.seconds);
+
+    if (!r.solved) return;
+    printf("        ");
+    size_t i;
+    for (i = 0; i < r.path_len; ++i) {
+        char action[32];
+        solve_action_name(r.path[i], action, sizeof action);
+        printf("%s%s", i > 0 ? ", " : "", action);
+    }
+    printf("\n");
+}
+
+/**
+ * Sequential search against 1 thread up to every core on a board that
+ * solves and on boss, which gives up after SOLVE_BENCH_NODES states
+ */
+void solve_bench(const SolvePuzzle *puzzles, size_t len)
+{
+    const char *names[] = { "fun5", "boss" };
+    size_t n;
+    for (n = 0; n < sizeof names / sizeof *names; ++n) {
+        const SolvePuzzle *puzzle = NULL;
+        size_t i;
+        for (i = 0; i < len; ++i) {
+            if (strcmp(puzzles[i].name, names[n]) == 0) puzzle = &puzzles[i];
+        }
+        ASSERT(puzzle != NULL, "No puzzle %s", names[n]);
+
+        SolveLimits limits = solve_limits_default();
+        if (strcmp(puzzle->name, "boss") == 0) limits.nodes_max = SOLVE_BENCH_NODES;
+        SolveResult reference = solve_puzzle(puzzle->bytes, limits);
+        printf("%-6s sequential | %8.3f s | %9.0f states/s | %s\n", puzzle->name, reference.seconds,
+               reference.explored / reference.seconds, reference.solved ? "solved" : "gave up");
+
+        double single_s = 0.f;
+        size_t max = light_threads_default();
+        size_t threads;
+        for (threads = 1; threads <= max; threads = threads < max && threads * 2 > max ? max : threads * 2) {
+            SolveResult r = solve_puzzle_parallel(puzzle->bytes, limits, threads);
+            if (threads == 1) single_s = r.seconds;
+            // Solved boards must agree on the cost, boards that gave up only on giving up
+            bool same = r.solved == reference.solved && r.gave_up == reference.gave_up && r.cost == reference.cost;
+            printf("%-6s %2zu threads | %8.3f s | %9.0f states/s | %5.2fx | %s\n", puzzle->name, threads, r.seconds,
+                   r.explored / r.seconds, single_s / r.seconds, same ? "same" : "MISMATCH");
+            ASSERT(same, "Parallel search differs from sequential");
+            solve_result_free(&r);
+            if (threads == max) break;
+        }
+        solve_result_free(&reference);
+    }
+}
+
+/**
+ * Solves the puzzles named in argv, or all of them. -j n searches with n
+ * threads, -bench compares thread counts. A puzzle whose cheapest solution
+ * is out of reach is searched again greedily, for any solution
+ */
+int main(int argc, char **argv)
+{
+    SolvePuzzle puzzles[FUN_PUZZLES + TRAIN_PUZZLES + 1];
+    size_t len = solve_puzzles(puzzles);
+    SolveLimits limits = solve_limits_default();
+
+    size_t threads = 0;
+    int first = 1;
+    if (argc > 1 && strcmp(argv[1], "-bench") == 0) {
+        solve_bench(puzzles, len);
+        return 0;
+    }
+    if (argc > 2 && strcmp(argv[1], "-j") == 0) {
+        threads = strtoul(argv[2], NULL, 10);
+        first = 3;
+    }
+
+    size_t i;
+    for (i = 0; i < len; ++i) {
+        bool selected = argc <= first;
+        int a;
+        for (a = first; a < argc; ++a) {
+            if (strcmp(argv[a], puzzles[i].name) == 0) selected = true;
+        }
+        if (!selected) continue;
+
+        SolveResult r = threads > 0 ? solve_puzzle_parallel(puzzles[i].bytes, limits, threads)
+            : solve_puzzle(puzzles[i].bytes, limits);
+        bool greedy = r.gave_up;
+        if (greedy) {
+            SolveLimits any = limits;
+            any.greedy = true;
+            SolveResult exact = r;
+            r = threads > 0 ? solve_puzzle_parallel(puzzles[i].bytes, any, threads) : solve_puzzle(puzzles[i].bytes, any);
+            // Both searches count
+            r.explored += exact.explored;
+            r.seconds += exact.seconds;
+            solve_result_free(&exact);
+        }
+        solve_print(puzzles[i].name, puzzles[i].bytes, r, greedy);
+        solve_result_free(&r);
+    }
+    return 0;
+}
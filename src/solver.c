@@ -0,0 +1,1257 @@
+#define _POSIX_C_SOURCE 200809L
+#include "solver.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <time.h>
+
+#include "bitboard.h"
+#include "puzzle.h"
+
+#define SOLVE_NONE UINT32_MAX
+#define SOLVE_NODES_INIT 4096
+#define SOLVE_STARTS_MAX 64  /* Starting clones, one bit each in a packed state */
+#define SOLVE_ACTIONS_MAX (8 + 4 * BITBOARD_MAX)
+#define SOLVE_GOALS_MAX 64
+#define SOLVE_ENTRY(hash, node) (((hash) & 0xffffffff00000000ull) | ((node) + 1))
+#define SOLVE_FAR UINT8_MAX  /* Distance of a goal no clone can walk to */
+#define SOLVE_STRIPES_LOG2 6
+#define SOLVE_STRIPES (1 << SOLVE_STRIPES_LOG2)  /* Locks over the parallel table */
+#define SOLVE_CHUNK (1 << 14)  /* Nodes a parallel worker takes from the pool at once */
+
+typedef struct SolveNode {
+    u64 hash;
+    u32 parent;  /* SOLVE_NONE for the start */
+    u32 cost;
+    u32 moves;  /* Actions since the start */
+    u16 rolls;
+    u16 clones;
+    SolveAction action;  /* Leading here from parent */
+    bool closed;
+} SolveNode;
+
+typedef struct SolveOpen {
+    u32 f;  /* cost + heuristic, or the heuristic alone when greedy */
+    u32 rank;  /* Breaks ties of f, see solver_rank */
+    u32 cost;
+    u32 moves;
+    u32 node;
+} SolveOpen;
+
+/**
+ * Heuristic buffers, per goal and clone then per clone
+ */
+typedef struct SolveScratch {
+    u8 *near;
+    u8 *match;
+    u32 *seen;
+    u32 stamp;
+} SolveScratch;
+
+typedef struct Solver {
+    BitboardMap map;
+    Bitboard start;
+    size_t words;  /* Packed state: the cells row after row, then the fresh bits */
+    size_t starts;
+    U8x2 start_pos[SOLVE_STARTS_MAX];
+    u64 *zobrist;  /* One key per cell, then one per starting clone */
+    size_t goals;
+    u8 *goal_dist;  /* Per goal and cell, the rolls a clone there needs to reach the goal */
+    u8 *fresh_dist;  /* The same for a starting clone that has not moved yet */
+    u8 *goal_steps;  /* As goal_dist, counting every step instead of the rolls */
+    u8 *fresh_steps;
+    u32 roll_cost;
+    u32 clone_cost;
+    size_t rolls_max;
+    size_t clones_max;
+    size_t nodes_max;
+    bool greedy;
+    SolveAction actions[SOLVE_ACTIONS_MAX];
+    size_t actions_len;
+
+    SolveNode *nodes;
+    u64 *states;  /* words per node */
+    size_t len;
+    size_t cap;
+    u64 *table;  /* High half of the hash over node index + 1, 0 when empty */
+    size_t table_cap;
+    SolveOpen *open;
+    size_t open_len;
+    size_t open_cap;
+    SolveScratch scratch;
+} Solver;
+
+static const Direction solve_dirs[] = { UP, DOWN, LEFT, RIGHT };
+
+double solve_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+SolveLimits solve_limits_default(void)
+{
+    return (SolveLimits) {
+        .energy = ENERGY_MAX_LIM,
+        .pain = PAIN_INIT,
+        .nodes_max = SOLVE_NODES_MAX,
+    };
+}
+
+void solve_action_name(SolveAction action, char *buf, size_t len)
+{
+    static const char *dirs[] = { "up", "down", "left", "right" };
+    switch (action.kind) {
+        case SOLVE_MOVE: { snprintf(buf, len, "%s", dirs[action.dir]); } break;
+        case SOLVE_ROLL: { snprintf(buf, len, "roll %s", dirs[action.dir]); } break;
+        case SOLVE_MIRROR: {
+            bool row = action.options & (MIRROR_UP | MIRROR_DOWN);
+            const char *dir = action.options & MIRROR_UP ? "up"
+                : action.options & MIRROR_DOWN ? "down"
+                : action.options & MIRROR_LEFT ? "left" : "right";
+            snprintf(buf, len, "mirror %s %d %s", row ? "row" : "col", action.line, dir);
+        } break;
+    }
+}
+
+u64 solve_splitmix(u64 *x)
+{
+    u64 z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void solver_pack(const Solver *s, const Bitboard *b, u64 *out)
+{
+    memset(out, 0, s->words * sizeof *out);
+    size_t cols = s->map.cols;
+    size_t y;
+    for (y = 0; y < s->map.rows; ++y) {
+        size_t bit = y * cols;
+        out[bit / 64] |= b->clones[y] << (bit % 64);
+        if (bit % 64 + cols > 64) out[bit / 64 + 1] |= b->clones[y] >> (64 - bit % 64);
+    }
+    u64 fresh = 0;
+    size_t i;
+    for (i = 0; i < s->starts; ++i) {
+        U8x2 pos = s->start_pos[i];
+        if ((b->fresh[pos.y] >> pos.x) & 1) fresh |= 1ull << i;
+    }
+    out[s->words - 1] = fresh;
+}
+
+void solver_unpack(const Solver *s, const u64 *in, Bitboard *b)
+{
+    size_t cols = s->map.cols;
+    size_t y;
+    for (y = 0; y < s->map.rows; ++y) {
+        size_t bit = y * cols;
+        u64 row = in[bit / 64] >> (bit % 64);
+        if (bit % 64 + cols > 64) row |= in[bit / 64 + 1] << (64 - bit % 64);
+        b->clones[y] = row & s->map.full;
+        b->fresh[y] = 0;
+    }
+    u64 fresh = in[s->words - 1];
+    while (fresh) {
+        U8x2 pos = s->start_pos[__builtin_ctzll(fresh)];
+        b->fresh[pos.y] |= 1ull << pos.x;
+        fresh &= fresh - 1;
+    }
+}
+
+u64 solver_hash(const Solver *s, const u64 *state)
+{
+    u64 hash = 0;
+    size_t w;
+    for (w = 0; w < s->words; ++w) {
+        // The fresh word follows the cells, as its keys do
+        const u64 *keys = w == s->words - 1 ? &s->zobrist[s->map.cols * s->map.rows] : &s->zobrist[w * 64];
+        u64 v = state[w];
+        while (v) {
+            hash ^= keys[__builtin_ctzll(v)];
+            v &= v - 1;
+        }
+    }
+    return hash;
+}
+
+/**
+ * Fills dist with a 0-1 BFS back from goal. A clone steps onto a lower or
+ * equal cell for free and one higher with a roll, the other clones
+ * ignored. With steps set every step costs 1
+ */
+void solver_bfs(const Solver *s, const u8 *height, size_t goal, bool steps, u8 *dist, size_t *deque)
+{
+    static const int dx[] = { 0, 0, -1, 1 };
+    static const int dy[] = { -1, 1, 0, 0 };
+    size_t cols = s->map.cols;
+    size_t rows = s->map.rows;
+    size_t cells = cols * rows;
+    memset(dist, SOLVE_FAR, cells);
+    dist[goal] = 0;
+    // Free steps go to the front, the others to the back. Each of the four
+    // edges of a cell pushes at most once
+    size_t head = 4 * cells;
+    size_t tail = 4 * cells;
+    deque[tail++] = goal;
+    while (head < tail) {
+        size_t b = deque[head++];
+        size_t d;
+        for (d = 0; d < 4; ++d) {
+            int ax = (int) (b % cols) + dx[d];
+            int ay = (int) (b / cols) + dy[d];
+            if (ax < 0 || ay < 0 || ax >= (int) cols || ay >= (int) rows) continue;
+            size_t a = ay * cols + ax;
+            if (height[b] > bitboard_reach(height[a], true)) continue;
+            int cost = steps || height[b] > height[a];
+            if (dist[b] + cost >= dist[a]) continue;
+            dist[a] = dist[b] + cost;
+            if (cost) deque[tail++] = a;
+            else deque[--head] = a;
+        }
+    }
+}
+
+/**
+ * Fills fresh from dist for a starting clone, which climbs anything on its
+ * first step
+ */
+void solver_fresh(const Solver *s, size_t goal, bool steps, const u8 *dist, u8 *fresh)
+{
+    static const int dx[] = { 0, 0, -1, 1 };
+    static const int dy[] = { -1, 1, 0, 0 };
+    size_t cols = s->map.cols;
+    size_t rows = s->map.rows;
+    size_t a;
+    for (a = 0; a < cols * rows; ++a) {
+        fresh[a] = a == goal ? 0 : SOLVE_FAR;
+        size_t d;
+        for (d = 0; d < 4; ++d) {
+            int bx = (int) (a % cols) + dx[d];
+            int by = (int) (a / cols) + dy[d];
+            if (bx < 0 || by < 0 || bx >= (int) cols || by >= (int) rows) continue;
+            u8 b = dist[by * cols + bx];
+            if (b + steps < SOLVE_FAR) fresh[a] = MIN(fresh[a], b + steps);
+        }
+    }
+}
+
+/**
+ * Fills goal_dist, fresh_dist and the step counts for every goal
+ */
+void solver_distances(Solver *s)
+{
+    size_t cols = s->map.cols;
+    size_t cells = cols * s->map.rows;
+    u8 *height = malloc(cells);
+    size_t *deque = malloc((8 * cells + 1) * sizeof *deque);
+    s->goal_dist = malloc(s->goals * cells);
+    s->fresh_dist = malloc(s->goals * cells);
+    s->goal_steps = malloc(s->goals * cells);
+    s->fresh_steps = malloc(s->goals * cells);
+    ASSERT(height != NULL && deque != NULL && s->goal_dist != NULL && s->fresh_dist != NULL &&
+            s->goal_steps != NULL && s->fresh_steps != NULL, "Malloc failed");
+
+    size_t c;
+    for (c = 0; c < cells; ++c) {
+        int h = 0;
+        while (!((s->map.level[h][c / cols] >> (c % cols)) & 1)) h += 1;
+        height[c] = h;
+    }
+
+    size_t g = 0;
+    for (c = 0; c < cells; ++c) {
+        if (!((s->map.goals[c / cols] >> (c % cols)) & 1)) continue;
+        solver_bfs(s, height, c, false, &s->goal_dist[g * cells], deque);
+        solver_fresh(s, c, false, &s->goal_dist[g * cells], &s->fresh_dist[g * cells]);
+        solver_bfs(s, height, c, true, &s->goal_steps[g * cells], deque);
+        solver_fresh(s, c, true, &s->goal_steps[g * cells], &s->fresh_steps[g * cells]);
+        g += 1;
+    }
+    free(height);
+    free(deque);
+}
+
+/**
+ * Kuhn augmenting path from goal g over clones at most rolls away
+ */
+bool solver_augment(const Solver *s, SolveScratch *sc, size_t g, size_t clones, size_t rolls)
+{
+    size_t k;
+    for (k = 0; k < clones; ++k) {
+        if (sc->near[g * s->map.cols * s->map.rows + k] > rolls || sc->seen[k] == sc->stamp) continue;
+        sc->seen[k] = sc->stamp;
+        if (sc->match[k] == SOLVE_FAR || solver_augment(s, sc, sc->match[k], clones, rolls)) {
+            sc->match[k] = g;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Lower bound on the cost left. With r rolls every goal needs its own
+ * clone, one that can walk there in r rolls or a new one from a mirror,
+ * so the cost is at least the cheapest r * roll_cost plus clone_cost per
+ * goal left out of a matching of goals to clones in reach
+ * Returns SOLVE_NONE if no matching fits the budgets left
+ */
+u32 solver_heuristic(const Solver *s, SolveScratch *sc, const Bitboard *b, size_t rolls_left, size_t clones_left)
+{
+    size_t cols = s->map.cols;
+    size_t cells = cols * s->map.rows;
+    size_t clones = 0;
+    size_t y;
+    for (y = 0; y < s->map.rows; ++y) {
+        u64 row = b->clones[y];
+        while (row) {
+            size_t x = __builtin_ctzll(row);
+            size_t c = y * cols + x;
+            const u8 *dist = (b->fresh[y] >> x) & 1 ? s->fresh_dist : s->goal_dist;
+            size_t g;
+            for (g = 0; g < s->goals; ++g) {
+                sc->near[g * cells + clones] = dist[g * cells + c];
+            }
+            clones += 1;
+            row &= row - 1;
+        }
+    }
+
+    u32 best = SOLVE_NONE;
+    size_t r;
+    for (r = 0; r <= rolls_left && r * s->roll_cost < best; ++r) {
+        memset(sc->match, SOLVE_FAR, clones);
+        size_t matched = 0;
+        size_t g;
+        for (g = 0; g < s->goals; ++g) {
+            sc->stamp += 1;
+            if (sc->stamp == 0) {
+                memset(sc->seen, 0, cells * sizeof *sc->seen);
+                sc->stamp = 1;
+            }
+            if (solver_augment(s, sc, g, clones, r)) matched += 1;
+        }
+        if (s->goals - matched > clones_left) continue;
+        best = MIN(best, r * s->roll_cost + (s->goals - matched) * s->clone_cost);
+        if (matched == s->goals) break;
+    }
+    return best;
+}
+
+/**
+ * Steps from every goal to its nearest clone, summed. Not a bound, as one
+ * clone may be nearest to several goals, but it tells apart the states
+ * the heuristic ranks the same
+ */
+u32 solver_spread(const Solver *s, const Bitboard *b)
+{
+    size_t cols = s->map.cols;
+    size_t cells = cols * s->map.rows;
+    u8 nearest[SOLVE_GOALS_MAX];
+    memset(nearest, SOLVE_FAR, s->goals);
+    size_t y;
+    for (y = 0; y < s->map.rows; ++y) {
+        u64 row = b->clones[y];
+        while (row) {
+            size_t x = __builtin_ctzll(row);
+            size_t c = y * cols + x;
+            const u8 *steps = (b->fresh[y] >> x) & 1 ? s->fresh_steps : s->goal_steps;
+            size_t g;
+            for (g = 0; g < s->goals; ++g) {
+                nearest[g] = MIN(nearest[g], steps[g * cells + c]);
+            }
+            row &= row - 1;
+        }
+    }
+    u32 spread = 0;
+    size_t g;
+    for (g = 0; g < s->goals; ++g) {
+        spread += nearest[g];
+    }
+    return spread;
+}
+
+/**
+ * Actions so far plus the spread as a guess at the ones left, so ties go
+ * to short solutions. A greedy search only wants any solution soon, and
+ * goes for the nearest one
+ */
+u32 solver_rank(const Solver *s, const Bitboard *b, u32 moves)
+{
+    return (s->greedy ? 0 : moves) + solver_spread(s, b);
+}
+
+void solve_scratch_init(const Solver *s, SolveScratch *sc)
+{
+    size_t cells = s->map.cols * s->map.rows;
+    sc->near = malloc(s->goals * cells);
+    sc->match = malloc(cells);
+    sc->seen = calloc(cells, sizeof *sc->seen);
+    sc->stamp = 0;
+    ASSERT(sc->near != NULL && sc->match != NULL && sc->seen != NULL, "Malloc failed");
+}
+
+void solve_scratch_free(SolveScratch *sc)
+{
+    free(sc->near);
+    free(sc->match);
+    free(sc->seen);
+}
+
+/**
+ * Rolls before the game faints, by charging energy as apply_energy_loss
+ * does and testing it as should_faint does, float rounding and all
+ */
+size_t solver_rolls_max(float energy)
+{
+    size_t n;
+    for (n = 0; n < UINT16_MAX; ++n) {
+        energy -= PENALTY_ENERGY;
+        if (energy < 0) break;
+    }
+    return n;
+}
+
+/**
+ * Clones before the game faints, as apply_pain and should_faint count them
+ */
+size_t solver_clones_max(float pain)
+{
+    size_t n;
+    for (n = 0; n < UINT16_MAX; ++n) {
+        pain += PENALTY_PAIN;
+        if (pain > PAIN_MAX) break;
+    }
+    return n;
+}
+
+void solver_init(Solver *s, const unsigned char *bytes, SolveLimits limits)
+{
+    memset(s, 0, sizeof *s);
+    bitboard_load(&s->map, &s->start, bytes);
+    size_t cells = s->map.cols * s->map.rows;
+    s->words = (cells + 63) / 64 + 1;
+
+    size_t x, y;
+    for (y = 0; y < s->map.rows; ++y) {
+        s->goals += __builtin_popcountll(s->map.goals[y]);
+        ASSERT(s->goals <= SOLVE_GOALS_MAX, "More than %d goals", SOLVE_GOALS_MAX);
+        for (x = 0; x < s->map.cols; ++x) {
+            if (!((s->start.fresh[y] >> x) & 1)) continue;
+            ASSERT(s->starts < SOLVE_STARTS_MAX, "More than %d starting clones", SOLVE_STARTS_MAX);
+            s->start_pos[s->starts] = (U8x2) { x, y };
+            s->starts += 1;
+        }
+    }
+
+    u64 seed = 0x7261696e626f77ull;
+    s->zobrist = malloc((cells + s->starts) * sizeof *s->zobrist);
+    ASSERT(s->zobrist != NULL, "Malloc failed");
+    size_t i;
+    for (i = 0; i < cells + s->starts; ++i) {
+        s->zobrist[i] = solve_splitmix(&seed);
+    }
+
+    s->roll_cost = lroundf(PENALTY_ENERGY * SOLVE_COST_UNIT);
+    s->clone_cost = lroundf(PENALTY_PAIN * SOLVE_COST_UNIT);
+    s->rolls_max = solver_rolls_max(limits.energy);
+    s->clones_max = solver_clones_max(limits.pain);
+    s->nodes_max = limits.nodes_max;
+    s->greedy = limits.greedy;
+    solver_distances(s);
+
+    size_t d;
+    for (d = 0; d < 4; ++d) {
+        s->actions[s->actions_len++] = (SolveAction) { .kind = SOLVE_MOVE, .dir = d };
+        s->actions[s->actions_len++] = (SolveAction) { .kind = SOLVE_ROLL, .dir = d };
+    }
+    for (i = 1; i < s->map.rows; ++i) {
+        s->actions[s->actions_len++] = (SolveAction) { .kind = SOLVE_MIRROR, .line = i, .options = MIRROR_UP };
+        s->actions[s->actions_len++] = (SolveAction) { .kind = SOLVE_MIRROR, .line = i, .options = MIRROR_DOWN };
+    }
+    for (i = 1; i < s->map.cols; ++i) {
+        s->actions[s->actions_len++] = (SolveAction) { .kind = SOLVE_MIRROR, .line = i, .options = MIRROR_LEFT };
+        s->actions[s->actions_len++] = (SolveAction) { .kind = SOLVE_MIRROR, .line = i, .options = MIRROR_RIGHT };
+    }
+
+    s->cap = SOLVE_NODES_INIT;
+    s->nodes = malloc(s->cap * sizeof *s->nodes);
+    s->states = malloc(s->cap * s->words * sizeof *s->states);
+    s->table_cap = 2 * SOLVE_NODES_INIT;
+    s->table = calloc(s->table_cap, sizeof *s->table);
+    s->open_cap = SOLVE_NODES_INIT;
+    s->open = malloc(s->open_cap * sizeof *s->open);
+    ASSERT(s->nodes != NULL && s->states != NULL && s->table != NULL && s->open != NULL, "Malloc failed");
+    solve_scratch_init(s, &s->scratch);
+}
+
+void solver_free(Solver *s)
+{
+    free(s->zobrist);
+    free(s->nodes);
+    free(s->states);
+    free(s->table);
+    free(s->open);
+    free(s->goal_dist);
+    free(s->fresh_dist);
+    free(s->goal_steps);
+    free(s->fresh_steps);
+    solve_scratch_free(&s->scratch);
+}
+
+/**
+ * Whether a state reached as a leaves at least the budgets b leaves. Costs
+ * alone do not tell, as two rolls cost what one clone does
+ */
+bool solve_covers(const SolveNode *a, const SolveNode *b)
+{
+    return a->rolls <= b->rolls && a->clones <= b->clones;
+}
+
+/**
+ * Looks state up for child. Returns false when a node holding it covers
+ * child, so nothing follows from child that does not from that node.
+ * Otherwise sets n to a node holding it that child covers, to be replaced,
+ * or SOLVE_NONE, and slot to where a new node would go
+ */
+bool solver_find(const Solver *s, u64 hash, const u64 *state, const SolveNode *child, size_t *slot, u32 *n)
+{
+    *n = SOLVE_NONE;
+    size_t mask = s->table_cap - 1;
+    size_t i;
+    for (i = hash & mask; s->table[i] != 0; i = (i + 1) & mask) {
+        if ((s->table[i] ^ hash) >> 32 != 0) continue;
+        u32 node = (u32) s->table[i] - 1;
+        if (s->nodes[node].hash != hash || memcmp(&s->states[node * s->words], state, s->words * sizeof *state) != 0) {
+            continue;
+        }
+        if (solve_covers(&s->nodes[node], child)) return false;
+        if (*n == SOLVE_NONE && solve_covers(child, &s->nodes[node])) *n = node;
+    }
+    *slot = i;
+    return true;
+}
+
+/**
+ * Doubles the transposition table once it is half full
+ */
+void solver_table_grow(Solver *s)
+{
+    if (2 * s->len < s->table_cap) return;
+    free(s->table);
+    s->table_cap *= 2;
+    s->table = calloc(s->table_cap, sizeof *s->table);
+    ASSERT(s->table != NULL, "Calloc failed");
+    size_t mask = s->table_cap - 1;
+    size_t n;
+    for (n = 0; n < s->len; ++n) {
+        size_t i;
+        u64 hash = s->nodes[n].hash;
+        for (i = hash & mask; s->table[i] != 0; i = (i + 1) & mask);
+        s->table[i] = SOLVE_ENTRY(hash, n);
+    }
+}
+
+u32 solver_add(Solver *s, size_t slot, const u64 *state, SolveNode node)
+{
+    if (s->len >= s->cap) {
+        s->cap *= 2;
+        s->nodes = realloc(s->nodes, s->cap * sizeof *s->nodes);
+        s->states = realloc(s->states, s->cap * s->words * sizeof *s->states);
+        ASSERT(s->nodes != NULL && s->states != NULL, "Realloc failed");
+    }
+    u32 n = s->len;
+    s->nodes[n] = node;
+    memcpy(&s->states[n * s->words], state, s->words * sizeof *state);
+    s->table[slot] = SOLVE_ENTRY(node.hash, n);
+    s->len += 1;
+    solver_table_grow(s);
+    return n;
+}
+
+bool solve_open_less(SolveOpen a, SolveOpen b)
+{
+    if (a.f != b.f) return a.f < b.f;
+    if (a.rank != b.rank) return a.rank < b.rank;
+    if (a.moves != b.moves) return a.moves < b.moves;
+    return a.node < b.node;
+}
+
+/**
+ * Pushes e onto the binary heap open, of len entries with room for cap
+ */
+void solve_heap_push(SolveOpen **open, size_t *len, size_t *cap, SolveOpen e)
+{
+    if (*len >= *cap) {
+        *cap = *cap > 0 ? 2 * *cap : SOLVE_NODES_INIT;
+        *open = realloc(*open, *cap * sizeof **open);
+        ASSERT(*open != NULL, "Realloc failed");
+    }
+    SolveOpen *heap = *open;
+    size_t i = (*len)++;
+    while (i > 0 && solve_open_less(e, heap[(i - 1) / 2])) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = e;
+}
+
+SolveOpen solve_heap_pop(SolveOpen *open, size_t *len)
+{
+    SolveOpen top = open[0];
+    SolveOpen last = open[--*len];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= *len) break;
+        if (child + 1 < *len && solve_open_less(open[child + 1], open[child])) child += 1;
+        if (!solve_open_less(open[child], last)) break;
+        open[i] = open[child];
+        i = child;
+    }
+    if (*len > 0) open[i] = last;
+    return top;
+}
+
+void solver_push(Solver *s, u32 n, u32 f, u32 rank)
+{
+    SolveNode *node = &s->nodes[n];
+    SolveOpen e = {
+        .f = f,
+        .rank = rank,
+        .cost = node->cost,
+        .moves = node->moves,
+        .node = n,
+    };
+    solve_heap_push(&s->open, &s->open_len, &s->open_cap, e);
+}
+
+/**
+ * Applies action to b. Returns whether anything changed and sets the
+ * rolls and clones it charges
+ */
+bool solver_apply(const Solver *s, Bitboard *b, SolveAction action, size_t *rolls, size_t *clones)
+{
+    *rolls = 0;
+    *clones = 0;
+    switch (action.kind) {
+        case SOLVE_MOVE: { return bitboard_move(&s->map, b, solve_dirs[action.dir], false) > 0; } break;
+        case SOLVE_ROLL: {
+            if (bitboard_move(&s->map, b, solve_dirs[action.dir], true) == 0) return false;
+            *rolls = 1;
+            return true;
+        } break;
+        case SOLVE_MIRROR: {
+            *clones = bitboard_mirror(&s->map, b, action.line, action.options);
+            return *clones > 0;
+        } break;
+    }
+    return false;
+}
+
+/**
+ * Sets the rolls, clones and cost of the path in result by playing it
+ */
+void solver_replay(const Solver *s, SolveResult *result)
+{
+    Bitboard b = s->start;
+    result->rolls = 0;
+    result->clones = 0;
+    size_t i;
+    for (i = 0; i < result->path_len; ++i) {
+        size_t rolls, clones;
+        solver_apply(s, &b, result->path[i], &rolls, &clones);
+        result->rolls += rolls;
+        result->clones += clones;
+    }
+    result->cost = result->rolls * s->roll_cost + result->clones * s->clone_cost;
+    ASSERT(bitboard_is_finished(&s->map, &b), "Replayed path does not finish the puzzle");
+}
+
+/**
+ * Walks back from the finished node n. Its parents may since have been
+ * reached cheaper and not expanded again, so the path is counted and
+ * replayed rather than taken from n
+ */
+void solver_path(const Solver *s, u32 n, SolveResult *result)
+{
+    size_t len = 0;
+    u32 p;
+    for (p = n; s->nodes[p].parent != SOLVE_NONE; p = s->nodes[p].parent) {
+        len += 1;
+    }
+    result->path = malloc((len > 0 ? len : 1) * sizeof *result->path);
+    ASSERT(result->path != NULL, "Malloc failed");
+    result->path_len = len;
+    for (p = n; s->nodes[p].parent != SOLVE_NONE; p = s->nodes[p].parent) {
+        result->path[--len] = s->nodes[p].action;
+    }
+    solver_replay(s, result);
+}
+
+/**
+ * Forgets every state, keeping the tables allocated
+ */
+void solver_reset(Solver *s)
+{
+    s->len = 0;
+    s->open_len = 0;
+    memset(s->table, 0, s->table_cap * sizeof *s->table);
+}
+
+/**
+ * One A* pass that keeps only states whose cost plus heuristic is at most
+ * bound, so children that cost a lot more, like mirrors adding many clones,
+ * take no memory until the cheaper ones are exhausted. A greedy search
+ * ranks states by the heuristic alone
+ * Returns the smallest cut off cost plus heuristic, or SOLVE_NONE
+ */
+u32 solver_search(Solver *s, u32 bound, SolveResult *result)
+{
+    u32 next_bound = SOLVE_NONE;
+    u64 *state = malloc(s->words * sizeof *state);
+    ASSERT(state != NULL, "Malloc failed");
+    solver_pack(s, &s->start, state);
+    size_t slot;
+    u32 n;
+    SolveNode start = { .hash = solver_hash(s, state), .parent = SOLVE_NONE };
+    solver_find(s, start.hash, state, &start, &slot, &n);
+    u32 h = solver_heuristic(s, &s->scratch, &s->start, s->rolls_max, s->clones_max);
+    if (h == SOLVE_NONE) {
+        free(state);
+        return SOLVE_NONE;
+    }
+    u32 root = solver_add(s, slot, state, start);
+    solver_push(s, root, h, solver_rank(s, &s->start, 0));
+
+    Bitboard b, next;
+    while (s->open_len > 0 && !result->gave_up) {
+        SolveOpen e = solve_heap_pop(s->open, &s->open_len);
+        SolveNode node = s->nodes[e.node];
+        if (node.closed || e.cost != node.cost || e.moves != node.moves) {
+            continue;  // Reached cheaper since pushed
+        }
+        s->nodes[e.node].closed = true;
+        result->explored += 1;
+
+        solver_unpack(s, &s->states[e.node * s->words], &b);
+        if (bitboard_is_finished(&s->map, &b)) {
+            result->solved = true;
+            solver_path(s, e.node, result);
+            break;
+        }
+
+        size_t a;
+        for (a = 0; a < s->actions_len; ++a) {
+            memcpy(next.clones, b.clones, s->map.rows * sizeof *b.clones);
+            memcpy(next.fresh, b.fresh, s->map.rows * sizeof *b.fresh);
+            size_t rolls, clones;
+            if (!solver_apply(s, &next, s->actions[a], &rolls, &clones)) continue;
+            if (node.rolls + rolls > s->rolls_max || node.clones + clones > s->clones_max) continue;
+
+            SolveNode child = {
+                .parent = e.node,
+                .cost = node.cost + rolls * s->roll_cost + clones * s->clone_cost,
+                .moves = node.moves + 1,
+                .rolls = node.rolls + rolls,
+                .clones = node.clones + clones,
+                .action = s->actions[a],
+            };
+            solver_pack(s, &next, state);
+            child.hash = solver_hash(s, state);
+            // A costlier path is kept when it leaves more of one budget
+            if (!solver_find(s, child.hash, state, &child, &slot, &n)) continue;
+
+            // Goals left out of reach within the budgets
+            u32 h = solver_heuristic(s, &s->scratch, &next, s->rolls_max - child.rolls, s->clones_max - child.clones);
+            if (h == SOLVE_NONE) continue;
+            u32 f = s->greedy ? h : child.cost + h;
+            if (f > bound) {
+                next_bound = MIN(next_bound, f);
+                continue;
+            }
+            if (n == SOLVE_NONE) {
+                if (s->len >= s->nodes_max) {
+                    // Dropping states could miss the cheapest solution
+                    result->gave_up = true;
+                    break;
+                }
+                n = solver_add(s, slot, state, child);
+            } else {
+                // The heuristic is not consistent, so closed states reopen.
+                // child covers n, so it is also cheaper
+                s->nodes[n] = child;
+            }
+            solver_push(s, n, f, solver_rank(s, &next, child.moves));
+        }
+    }
+    result->generated = MAX(result->generated, s->len);
+    free(state);
+    return next_bound;
+}
+
+SolveResult solve_puzzle(const unsigned char *bytes, SolveLimits limits)
+{
+    double start = solve_now();
+    SolveResult result = { 0 };
+    Solver s;
+    solver_init(&s, bytes, limits);
+
+    // Raise the bound to the next cost that was cut, until a pass solves it.
+    // A greedy search cuts nothing, so it takes a single pass
+    u32 bound = solver_heuristic(&s, &s.scratch, &s.start, s.rolls_max, s.clones_max);
+    if (s.greedy && bound != SOLVE_NONE) bound = SOLVE_NONE - 1;
+    while (bound != SOLVE_NONE && !result.solved && !result.gave_up) {
+        solver_reset(&s);
+        bound = solver_search(&s, bound, &result);
+    }
+
+    result.seconds = solve_now() - start;
+    solver_free(&s);
+    return result;
+}
+
+/**
+ * Parallel search
+ *
+ * The same f-bound passes, run by threads that each keep a heap of states
+ * to expand in the order of solver_search. A worker takes its own best
+ * state, and the best one of another worker when it runs dry. States live
+ * in one table split in SOLVE_STRIPES stripes, each under its own lock, and
+ * nodes come from a pool handed out SOLVE_CHUNK at a time so workers rarely
+ * touch the same memory.
+ *
+ * Within a pass the order only changes how often a state is expanded: one
+ * reached cheaper is expanded again. Any finished state found has the cost
+ * of the bound, as every lower bound was searched in full before, so the
+ * cost is the sequential one. The path may be another among equally cheap
+ * ones. A greedy search keeps whichever solution a worker finds first.
+ */
+
+typedef struct SolveQueue {
+    pthread_mutex_t mutex;
+    SolveOpen *open;  /* Heap, as Solver.open */
+    size_t len;
+    size_t cap;
+} SolveQueue;
+
+typedef struct SolveStripe {
+    pthread_mutex_t mutex;
+    u64 *table;  /* As Solver.table */
+    size_t len;
+    size_t cap;
+} SolveStripe;
+
+typedef struct SolveShared {
+    const Solver *s;
+    u32 bound;
+    size_t threads;
+    SolveQueue *queues;
+    SolveStripe stripes[SOLVE_STRIPES];
+    SolveNode **nodes;  /* Chunks of SOLVE_CHUNK nodes */
+    u64 **states;
+    size_t chunks;  /* Handed out this pass */
+    size_t chunks_max;
+    size_t pending;  /* Tasks pushed and not yet expanded */
+    bool stop;
+    bool gave_up;
+    pthread_mutex_t found_mutex;
+    u32 found;
+} SolveShared;
+
+typedef struct SolveWorker {
+    SolveShared *sh;
+    size_t id;
+    pthread_t thread;
+    SolveScratch scratch;
+    u32 next;  /* Free nodes of its chunk */
+    u32 end;
+    u32 next_bound;
+    size_t explored;
+    size_t generated;
+} SolveWorker;
+
+SolveNode *solve_node(const SolveShared *sh, u32 n)
+{
+    return &sh->nodes[n / SOLVE_CHUNK][n % SOLVE_CHUNK];
+}
+
+u64 *solve_state(const SolveShared *sh, u32 n)
+{
+    return &sh->states[n / SOLVE_CHUNK][(n % SOLVE_CHUNK) * sh->s->words];
+}
+
+SolveStripe *solve_stripe(SolveShared *sh, u64 hash)
+{
+    return &sh->stripes[hash >> (64 - SOLVE_STRIPES_LOG2)];
+}
+
+/**
+ * As solver_find, within a stripe. The caller holds its lock
+ */
+bool solve_stripe_find(const SolveShared *sh, const SolveStripe *st, u64 hash, const u64 *state,
+        const SolveNode *child, size_t *slot, u32 *n)
+{
+    *n = SOLVE_NONE;
+    size_t mask = st->cap - 1;
+    size_t i;
+    for (i = hash & mask; st->table[i] != 0; i = (i + 1) & mask) {
+        if ((st->table[i] ^ hash) >> 32 != 0) continue;
+        u32 node = (u32) st->table[i] - 1;
+        if (solve_node(sh, node)->hash != hash ||
+                memcmp(solve_state(sh, node), state, sh->s->words * sizeof *state) != 0) {
+            continue;
+        }
+        if (solve_covers(solve_node(sh, node), child)) return false;
+        if (*n == SOLVE_NONE && solve_covers(child, solve_node(sh, node))) *n = node;
+    }
+    *slot = i;
+    return true;
+}
+
+void solve_stripe_add(const SolveShared *sh, SolveStripe *st, size_t slot, u64 hash, u32 n)
+{
+    st->table[slot] = SOLVE_ENTRY(hash, n);
+    st->len += 1;
+    if (2 * st->len < st->cap) return;
+
+    u64 *old = st->table;
+    size_t old_cap = st->cap;
+    st->cap *= 2;
+    st->table = calloc(st->cap, sizeof *st->table);
+    ASSERT(st->table != NULL, "Calloc failed");
+    size_t mask = st->cap - 1;
+    size_t j;
+    for (j = 0; j < old_cap; ++j) {
+        if (old[j] == 0) continue;
+        u64 h = solve_node(sh, (u32) old[j] - 1)->hash;
+        size_t i;
+        for (i = h & mask; st->table[i] != 0; i = (i + 1) & mask);
+        st->table[i] = old[j];
+    }
+    free(old);
+}
+
+/**
+ * Next node of the worker's chunk, taking a new chunk from the pool when it
+ * is used up. Returns SOLVE_NONE once the pool is empty
+ */
+u32 solve_worker_alloc(SolveWorker *w)
+{
+    SolveShared *sh = w->sh;
+    if (w->next == w->end) {
+        size_t chunk = __atomic_fetch_add(&sh->chunks, 1, __ATOMIC_RELAXED);
+        if (chunk >= sh->chunks_max) return SOLVE_NONE;
+        // Chunks stay allocated over passes, only one worker takes each
+        if (sh->nodes[chunk] == NULL) {
+            sh->nodes[chunk] = malloc(SOLVE_CHUNK * sizeof **sh->nodes);
+            sh->states[chunk] = malloc(SOLVE_CHUNK * sh->s->words * sizeof **sh->states);
+            ASSERT(sh->nodes[chunk] != NULL && sh->states[chunk] != NULL, "Malloc failed");
+        }
+        w->next = chunk * SOLVE_CHUNK;
+        w->end = w->next + SOLVE_CHUNK;
+    }
+    w->generated += 1;
+    return w->next++;
+}
+
+/**
+ * Best task of the worker's own queue, else the best of another one
+ */
+bool solve_take(SolveShared *sh, size_t id, SolveOpen *task)
+{
+    size_t i;
+    for (i = 0; i < sh->threads; ++i) {
+        SolveQueue *q = &sh->queues[(id + i) % sh->threads];
+        pthread_mutex_lock(&q->mutex);
+        bool some = q->len > 0;
+        if (some) *task = solve_heap_pop(q->open, &q->len);
+        pthread_mutex_unlock(&q->mutex);
+        if (some) return true;
+    }
+    return false;
+}
+
+void solve_push(SolveWorker *w, u32 n, const SolveNode *node, u32 f, u32 rank)
+{
+    SolveOpen e = {
+        .f = f,
+        .rank = rank,
+        .cost = node->cost,
+        .moves = node->moves,
+        .node = n,
+    };
+    SolveQueue *q = &w->sh->queues[w->id];
+    __atomic_fetch_add(&w->sh->pending, 1, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&q->mutex);
+    solve_heap_push(&q->open, &q->len, &q->cap, e);
+    pthread_mutex_unlock(&q->mutex);
+}
+
+void solve_stop(SolveShared *sh)
+{
+    __atomic_store_n(&sh->stop, true, __ATOMIC_RELEASE);
+}
+
+/**
+ * As the loop body of solver_search
+ */
+void solve_expand(SolveWorker *w, SolveOpen task, u64 *state)
+{
+    SolveShared *sh = w->sh;
+    const Solver *s = sh->s;
+    // Nodes change under their stripe lock, states never do
+    SolveStripe *st = solve_stripe(sh, solver_hash(s, solve_state(sh, task.node)));
+    pthread_mutex_lock(&st->mutex);
+    SolveNode node = *solve_node(sh, task.node);
+    pthread_mutex_unlock(&st->mutex);
+    if (node.cost != task.cost) return;  // Reached cheaper since pushed
+    w->explored += 1;
+
+    Bitboard b, next;
+    solver_unpack(s, solve_state(sh, task.node), &b);
+    if (bitboard_is_finished(&s->map, &b)) {
+        pthread_mutex_lock(&sh->found_mutex);
+        if (sh->found == SOLVE_NONE) sh->found = task.node;
+        pthread_mutex_unlock(&sh->found_mutex);
+        solve_stop(sh);
+        return;
+    }
+
+    size_t a;
+    for (a = 0; a < s->actions_len; ++a) {
+        memcpy(next.clones, b.clones, s->map.rows * sizeof *b.clones);
+        memcpy(next.fresh, b.fresh, s->map.rows * sizeof *b.fresh);
+        size_t rolls, clones;
+        if (!solver_apply(s, &next, s->actions[a], &rolls, &clones)) continue;
+        if (node.rolls + rolls > s->rolls_max || node.clones + clones > s->clones_max) continue;
+
+        SolveNode child = {
+            .parent = task.node,
+            .cost = node.cost + rolls * s->roll_cost + clones * s->clone_cost,
+            .moves = node.moves + 1,
+            .rolls = node.rolls + rolls,
+            .clones = node.clones + clones,
+            .action = s->actions[a],
+        };
+        solver_pack(s, &next, state);
+        child.hash = solver_hash(s, state);
+        SolveStripe *cst = solve_stripe(sh, child.hash);
+        size_t slot;
+        u32 n;
+        pthread_mutex_lock(&cst->mutex);
+        bool kept = solve_stripe_find(sh, cst, child.hash, state, &child, &slot, &n);
+        pthread_mutex_unlock(&cst->mutex);
+        if (!kept) continue;
+
+        // The heuristic runs unlocked, so the state is looked up again after
+        u32 h = solver_heuristic(s, &w->scratch, &next, s->rolls_max - child.rolls, s->clones_max - child.clones);
+        if (h == SOLVE_NONE) continue;
+        u32 f = s->greedy ? h : child.cost + h;
+        if (f > sh->bound) {
+            w->next_bound = MIN(w->next_bound, f);
+            continue;
+        }
+
+        pthread_mutex_lock(&cst->mutex);
+        if (!solve_stripe_find(sh, cst, child.hash, state, &child, &slot, &n)) {
+            n = SOLVE_NONE;
+        } else if (n == SOLVE_NONE) {
+            n = solve_worker_alloc(w);
+            if (n == SOLVE_NONE) {
+                pthread_mutex_unlock(&cst->mutex);
+                __atomic_store_n(&sh->gave_up, true, __ATOMIC_RELAXED);
+                solve_stop(sh);
+                return;
+            }
+            *solve_node(sh, n) = child;
+            memcpy(solve_state(sh, n), state, s->words * sizeof *state);
+            solve_stripe_add(sh, cst, slot, child.hash, n);
+        } else {
+            *solve_node(sh, n) = child;
+        }
+        pthread_mutex_unlock(&cst->mutex);
+        if (n != SOLVE_NONE) solve_push(w, n, &child, f, solver_rank(s, &next, child.moves));
+    }
+}
+
+void *solve_worker_run(void *arg)
+{
+    SolveWorker *w = arg;
+    SolveShared *sh = w->sh;
+    u64 *state = malloc(sh->s->words * sizeof *state);
+    ASSERT(state != NULL, "Malloc failed");
+
+    SolveOpen task;
+    while (!__atomic_load_n(&sh->stop, __ATOMIC_ACQUIRE)) {
+        if (!solve_take(sh, w->id, &task)) {
+            // Others may still push children of the states they expand
+            if (__atomic_load_n(&sh->pending, __ATOMIC_ACQUIRE) == 0) break;
+            sched_yield();
+            continue;
+        }
+        solve_expand(w, task, state);
+        __atomic_fetch_sub(&sh->pending, 1, __ATOMIC_RELEASE);
+    }
+    free(state);
+    return NULL;
+}
+
+/**
+ * As solver_path
+ */
+void solve_shared_path(SolveShared *sh, u32 found, SolveResult *result)
+{
+    size_t len = 0;
+    u32 n;
+    for (n = found; solve_node(sh, n)->parent != SOLVE_NONE; n = solve_node(sh, n)->parent) {
+        len += 1;
+    }
+    result->path = malloc((len > 0 ? len : 1) * sizeof *result->path);
+    ASSERT(result->path != NULL, "Malloc failed");
+    result->path_len = len;
+    for (n = found; solve_node(sh, n)->parent != SOLVE_NONE; n = solve_node(sh, n)->parent) {
+        result->path[--len] = solve_node(sh, n)->action;
+    }
+    solver_replay(sh->s, result);
+}
+
+/**
+ * One pass of threads workers, as solver_search
+ */
+u32 solve_shared_search(SolveShared *sh, SolveWorker *workers, SolveResult *result)
+{
+    const Solver *s = sh->s;
+    size_t i;
+    for (i = 0; i < SOLVE_STRIPES; ++i) {
+        memset(sh->stripes[i].table, 0, sh->stripes[i].cap * sizeof *sh->stripes[i].table);
+        sh->stripes[i].len = 0;
+    }
+    for (i = 0; i < sh->threads; ++i) {
+        sh->queues[i].len = 0;
+        workers[i].next = workers[i].end = 0;
+        workers[i].next_bound = SOLVE_NONE;
+    }
+    sh->chunks = 0;
+    sh->pending = 0;
+    sh->stop = false;
+    sh->found = SOLVE_NONE;
+
+    u64 *state = malloc(s->words * sizeof *state);
+    ASSERT(state != NULL, "Malloc failed");
+    solver_pack(s, &s->start, state);
+    u64 hash = solver_hash(s, state);
+    SolveStripe *st = solve_stripe(sh, hash);
+    size_t slot;
+    u32 n;
+    SolveNode start = { .hash = hash, .parent = SOLVE_NONE };
+    solve_stripe_find(sh, st, hash, state, &start, &slot, &n);
+    u32 root = solve_worker_alloc(&workers[0]);
+    ASSERT(root != SOLVE_NONE, "No room for the start");
+    *solve_node(sh, root) = start;
+    memcpy(solve_state(sh, root), state, s->words * sizeof *state);
+    solve_stripe_add(sh, st, slot, hash, root);
+    // Alone in the queues, so its rank does not matter
+    solve_push(&workers[0], root, solve_node(sh, root), 0, 0);
+    free(state);
+
+    // The calling thread is worker 0
+    size_t started = 1;
+    for (i = 1; i < sh->threads; ++i) {
+        if (pthread_create(&workers[i].thread, NULL, solve_worker_run, &workers[i]) != 0) break;
+        started += 1;
+    }
+    solve_worker_run(&workers[0]);
+    for (i = 1; i < started; ++i) {
+        pthread_join(workers[i].thread, NULL);
+    }
+
+    u32 next_bound = SOLVE_NONE;
+    size_t generated = 0;
+    for (i = 0; i < sh->threads; ++i) {
+        next_bound = MIN(next_bound, workers[i].next_bound);
+        result->explored += workers[i].explored;
+        generated += workers[i].generated;
+        workers[i].explored = workers[i].generated = 0;
+    }
+    result->generated = MAX(result->generated, generated);
+    if (sh->found != SOLVE_NONE) {
+        result->solved = true;
+        solve_shared_path(sh, sh->found, result);
+    } else if (sh->gave_up) {
+        result->gave_up = true;
+    }
+    return next_bound;
+}
+
+SolveResult solve_puzzle_parallel(const unsigned char *bytes, SolveLimits limits, size_t threads)
+{
+    double start = solve_now();
+    SolveResult result = { 0 };
+    Solver s;
+    solver_init(&s, bytes, limits);
+
+    SolveShared sh = {
+        .s = &s,
+        .threads = MAX(threads, 1),
+        .chunks_max = (limits.nodes_max + SOLVE_CHUNK - 1) / SOLVE_CHUNK,
+        .found_mutex = PTHREAD_MUTEX_INITIALIZER,
+    };
+    sh.queues = calloc(sh.threads, sizeof *sh.queues);
+    sh.nodes = calloc(sh.chunks_max, sizeof *sh.nodes);
+    sh.states = calloc(sh.chunks_max, sizeof *sh.states);
+    SolveWorker *workers = calloc(sh.threads, sizeof *workers);
+    ASSERT(sh.queues != NULL && sh.nodes != NULL && sh.states != NULL && workers != NULL, "Calloc failed");
+    size_t i;
+    for (i = 0; i < SOLVE_STRIPES; ++i) {
+        pthread_mutex_init(&sh.stripes[i].mutex, NULL);
+        sh.stripes[i].cap = SOLVE_NODES_INIT;
+        sh.stripes[i].table = calloc(sh.stripes[i].cap, sizeof *sh.stripes[i].table);
+        ASSERT(sh.stripes[i].table != NULL, "Calloc failed");
+    }
+    for (i = 0; i < sh.threads; ++i) {
+        pthread_mutex_init(&sh.queues[i].mutex, NULL);
+        workers[i].sh = &sh;
+        workers[i].id = i;
+        solve_scratch_init(&s, &workers[i].scratch);
+    }
+
+    u32 bound = solver_heuristic(&s, &s.scratch, &s.start, s.rolls_max, s.clones_max);
+    if (s.greedy && bound != SOLVE_NONE) bound = SOLVE_NONE - 1;
+    while (bound != SOLVE_NONE && !result.solved && !result.gave_up) {
+        sh.bound = bound;
+        bound = solve_shared_search(&sh, workers, &result);
+    }
+
+    for (i = 0; i < sh.threads; ++i) {
+        pthread_mutex_destroy(&sh.queues[i].mutex);
+        free(sh.queues[i].open);
+        solve_scratch_free(&workers[i].scratch);
+    }
+    for (i = 0; i < SOLVE_STRIPES; ++i) {
+        pthread_mutex_destroy(&sh.stripes[i].mutex);
+        free(sh.stripes[i].table);
+    }
+    for (i = 0; i < sh.chunks_max; ++i) {
+        free(sh.nodes[i]);
+        free(sh.states[i]);
+    }
+    free(sh.nodes);
+    free(sh.states);
+    free(sh.queues);
+    free(workers);
+    result.seconds = solve_now() - start;
+    solver_free(&s);
+    return result;
+}
+
+void solve_result_free(SolveResult *result)
+{
+    free(result->path);
+    result->path = NULL;
+    result->path_len = 0;
+}
@@ -0,0 +1,77 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "core.h"
+
+/**
+ * Headless puzzle search
+ *
+ * Searches the states of a puzzle, as bitboards, for the cheapest way to
+ * cover every goal. Moves are free, a roll that moves anything costs
+ * PENALTY_ENERGY and every clone a mirror adds costs PENALTY_PAIN, so the
+ * cost is the energy plus the pain the game charges.
+ *
+ * A* over that cost. The heuristic matches goals to clones that could walk
+ * there, alone, in a given number of rolls, and charges a PENALTY_PAIN per
+ * goal left over. As moves are free many states tie on it, and those with
+ * the fewest actions so far plus steps from the goals to their nearest
+ * clones go first, so solutions are short but not always the shortest.
+ * States are packed to one bit per cell, plus one bit per starting clone
+ * that has not moved yet, and deduplicated in a transposition table keyed
+ * by their Zobrist hash. A state reached again is dropped only when an
+ * earlier path used no more rolls and no more clones, as a costlier one
+ * may still leave more of the budget that runs out first.
+ *
+ * A greedy search ranks states by the heuristic alone, then by the steps
+ * from the goals to the clones, and on the larger boards finds a solution
+ * within the budgets long before the cheapest one.
+ * Either search that runs out of states proves the puzzle unsolvable
+ * within the budgets.
+ *
+ * No raylib calls, puzzles are read from their bytes.
+ */
+
+#define SOLVE_COST_UNIT 1000.f  /* Costs are integers, in thousandths of energy and pain */
+#define SOLVE_NODES_MAX (1 << 23)  /* States kept before the search gives up */
+
+typedef enum {
+    SOLVE_MOVE,
+    SOLVE_ROLL,
+    SOLVE_MIRROR,
+} SolveKind;
+
+typedef struct SolveAction {
+    u8 kind;  /* SolveKind */
+    u8 dir;  /* Index into UP, DOWN, LEFT, RIGHT for moves and rolls */
+    u8 line;  /* Grid line of a mirror, as in bitboard_mirror */
+    u8 options;  /* MIRROR_ flag of a mirror */
+} SolveAction;
+
+typedef struct SolveLimits {
+    float energy;  /* Energy at the start, the search never lets it drop below 0 */
+    float pain;  /* Pain at the start, the search never lets it pass PAIN_MAX */
+    size_t nodes_max;
+    bool greedy;  /* Any solution within the budgets, not the cheapest, found much sooner */
+} SolveLimits;
+
+typedef struct SolveResult {
+    bool solved;
+    bool gave_up;  /* Hit nodes_max, unsolved says nothing */
+    u32 cost;  /* In SOLVE_COST_UNIT */
+    size_t rolls;
+    size_t clones;  /* Added by mirrors */
+    SolveAction *path;
+    size_t path_len;
+    size_t explored;  /* States expanded */
+    size_t generated;  /* Distinct states seen */
+    double seconds;
+} SolveResult;
+
+SolveLimits solve_limits_default(void);
+SolveResult solve_puzzle(const unsigned char *bytes, SolveLimits limits);
+SolveResult solve_puzzle_parallel(const unsigned char *bytes, SolveLimits limits, size_t threads);
+void solve_result_free(SolveResult *result);
+void solve_action_name(SolveAction action, char *buf, size_t len);
+double solve_now(void);
+
+#endif  /* SOLVER_H */
@@ -0,0 +1,227 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitboard.h"
+#define CASE_IMPLEMENTATION
+#include "case.h"
+#include "core.h"
+#include "light.h"
+#include "puzzle.h"
+#include "solver.h"
+
+typedef struct ValidateJob {
+    char name[16];
+    unsigned char *bytes;
+    size_t trained;  /* Train puzzles a player must have won to play it */
+    SolveResult result;
+    bool greedy;  /* The cheapest search gave up, result is any solution */
+} ValidateJob;
+
+/**
+ * Workers take the next puzzle until none are left, as the light pool
+ * takes tiles
+ */
+static struct {
+    pthread_mutex_t mutex;
+    ValidateJob *jobs;
+    size_t len;
+    size_t next;
+} pool = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+/**
+ * Most energy a player can hold after winning trained train puzzles, added
+ * up in float as every train win adds it in the game
+ */
+float validate_energy(size_t trained)
+{
+    float energy = ENERGY_MAX_INIT;
+    size_t i;
+    for (i = 0; i < trained; ++i) {
+        energy += ENERGY_MAX_INC;
+    }
+    return energy;
+}
+
+/**
+ * Loads the puzzle through the game and compares its clones with the
+ * bitboard the solver starts from
+ */
+bool validate_load(const ValidateJob *job)
+{
+    Puzzle *p = load_puzzle(job->bytes);
+    BitboardMap map;
+    Bitboard start;
+    bitboard_load(&map, &start, job->bytes);
+
+    bool ok = true;
+    size_t goals = 0;
+    size_t x, y;
+    for (y = 0; y < map.rows; ++y) {
+        goals += __builtin_popcountll(map.goals[y]);
+        for (x = 0; x < map.cols; ++x) {
+            bool engine = puzzle_player_height_at(p, x, y) != -1;
+            bool clone = (start.clones[y] >> x) & 1;
+            if (engine != clone) {
+                ERROR("%s: at %zu, %zu the game has %s clone", job->name, x, y, engine ? "a" : "no");
+                ok = false;
+            }
+        }
+    }
+    if (goals == 0) {
+        ERROR("%s: no goals", job->name);
+        ok = false;
+    }
+    if (puzzle_is_finished(p)) {
+        ERROR("%s: finished as loaded", job->name);
+        ok = false;
+    }
+    free_puzzle(p);
+    return ok;
+}
+
+void *validate_worker(void *arg)
+{
+    (void) arg;
+    for (;;) {
+        pthread_mutex_lock(&pool.mutex);
+        size_t i = pool.next++;
+        pthread_mutex_unlock(&pool.mutex);
+        if (i >= pool.len) return NULL;
+
+        ValidateJob *job = &pool.jobs[i];
+        SolveLimits limits = solve_limits_default();
+        limits.energy = validate_energy(job->trained);
+        job->result = solve_puzzle(job->bytes, limits);
+        if (!job->result.gave_up) continue;
+
+        // Any solution still proves the puzzle solvable, as in make solve
+        SolveResult exact = job->result;
+        limits.greedy = true;
+        job->result = solve_puzzle(job->bytes, limits);
+        job->result.explored += exact.explored;
+        job->result.seconds += exact.seconds;
+        job->greedy = true;
+        solve_result_free(&exact);
+    }
+}
+
+/**
+ * Largest boards first, so the slow searches start together
+ */
+int validate_larger(const void *a, const void *b)
+{
+    const ValidateJob *ja = a;
+    const ValidateJob *jb = b;
+    return jb->bytes[0] * jb->bytes[1] - ja->bytes[0] * ja->bytes[1];
+}
+
+/**
+ * Rank of a result in the table, from proven cheapest to unsolvable
+ */
+int validate_kind(const ValidateJob *job)
+{
+    return job->result.solved ? (job->greedy ? 1 : 0) : job->result.gave_up ? 2 : 3;
+}
+
+/**
+ * Cheapest solutions first, then greedy ones, whose cost is only an upper
+ * bound, then searches that gave up and unsolvable puzzles
+ */
+int validate_cheaper(const void *a, const void *b)
+{
+    const ValidateJob *ja = a;
+    const ValidateJob *jb = b;
+    int ka = validate_kind(ja);
+    int kb = validate_kind(jb);
+    if (ka != kb) return ka - kb;
+    if (ja->result.cost != jb->result.cost) return (ja->result.cost > jb->result.cost) - (ja->result.cost < jb->result.cost);
+    return strcmp(ja->name, jb->name);
+}
+
+/**
+ * Proves every puzzle solvable with the energy a player can have when it
+ * is reached: train puzzles after the ones before them, fun puzzles and the
+ * boss, which are open from the start, before any. Fails on a puzzle that
+ * loads wrong or has no solution, and when both searches gave up, as that
+ * proves nothing either way
+ */
+int main(void)
+{
+    ValidateJob jobs[FUN_PUZZLES + TRAIN_PUZZLES + 1] = { 0 };
+    size_t len = 0;
+    size_t i;
+    for (i = 0; i < FUN_PUZZLES; ++i) {
+        snprintf(jobs[len].name, sizeof jobs[len].name, "fun%zu", i);
+        jobs[len].bytes = puzzle_fun_array[i];
+        jobs[len++].trained = 0;
+    }
+    for (i = 0; i < TRAIN_PUZZLES; ++i) {
+        snprintf(jobs[len].name, sizeof jobs[len].name, "train%zu", i);
+        jobs[len].bytes = puzzle_train_array[i];
+        jobs[len++].trained = i;
+    }
+    snprintf(jobs[len].name, sizeof jobs[len].name, "boss");
+    jobs[len].bytes = puzzle_boss;
+    jobs[len++].trained = 0;
+
+    bool ok = true;
+    for (i = 0; i < len; ++i) {
+        ok &= validate_load(&jobs[i]);
+    }
+
+    qsort(jobs, len, sizeof *jobs, validate_larger);
+    pool.jobs = jobs;
+    pool.len = len;
+    size_t threads = MIN(light_threads_default(), len);
+    pthread_t workers[LIGHT_THREADS_MAX];
+    size_t started = 0;
+    // The calling thread is a worker as well
+    for (i = 0; i + 1 < threads; ++i) {
+        if (pthread_create(&workers[i], NULL, validate_worker, NULL) != 0) break;
+        started += 1;
+    }
+    double start = solve_now();
+    validate_worker(NULL);
+    for (i = 0; i < started; ++i) {
+        pthread_join(workers[i], NULL);
+    }
+    double seconds = solve_now() - start;
+
+    qsort(jobs, len, sizeof *jobs, validate_cheaper);
+    // The length is of the solution found, which need not be the shortest
+    printf("%-8s %-5s | %-6s | %-7s | %-6s | %-6s | %9s | %8s\n",
+           "puzzle", "size", "budget", "length", "energy", "pain", "states", "seconds");
+    for (i = 0; i < len; ++i) {
+        const ValidateJob *job = &jobs[i];
+        const SolveResult *r = &job->result;
+        printf("%-8s %2dx%-2d | %6.3f | ", job->name, job->bytes[0], job->bytes[1], validate_energy(job->trained));
+        if (r->solved) {
+            printf("%7zu | %s%5.3f | %6.3f", r->path_len, job->greedy ? "~" : " ", r->rolls * PENALTY_ENERGY,
+                   r->clones * PENALTY_PAIN);
+        } else {
+            printf("%-24s", r->gave_up ? "gave up" : "UNSOLVABLE");
+        }
+        printf(" | %9zu | %8.3f\n", r->explored, r->seconds);
+
+        if (!r->solved && !r->gave_up) {
+            ERROR("%s: no solution from energy %.3f and pain %.3f", job->name,
+                    validate_energy(job->trained), solve_limits_default().pain);
+            ok = false;
+        }
+        if (r->gave_up) {
+            ERROR("%s: both searches gave up after %zu states, solvable or not", job->name, r->explored);
+            ok = false;
+        }
+    }
+    printf("%zu puzzles on %zu threads in %.3f s\n", len, started + 1, seconds);
+
+    for (i = 0; i < len; ++i) {
+        solve_result_free(&jobs[i].result);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "core.h"
+
+/**
+ * New format
+ * 0bxxxx0000: physical {type1[empty, ground, blinds, bed, door, puzzle1, puzzle2, window](3), height(1)}
+ * 4 bits for type: [empty, ground, blinds, bed, door, puzzle1, puzzle2, window]
+ * 2 bit for height: unwalkable, 1, 2, 3
+ * 2 bits reserved for metadata
+ *
+ * 0b0000xxxx: visual {2 type[empty, light, 2`reserved], 2 color, 4 brightness} (1)
+ * 2 bits type: [empty, spawn, `reserved`, `reserved`]
+ * 2 bits color: [white, blue, pink, black]
+ * 4 bits for brightness: 0-15
+ */
+
+/* Visual masks */
+#define MASK_PHYSICAL(a) ((a) & 0b11111111)
+#define MASK_PHYSICAL_T(a) ((a) & 0b00001111)
+#define MASK_HEIGHT(a) ((a) & 0b00110000)
+#define MASK_META(a) ((a) & 0b11000000)
+
+/* Visual masks */
+#define MASK_VISUAL(a) ((a) & (0b1111111 << 8))
+#define MASK_VISUAL_T(a) ((a) & (0b0000011 << 8))
+#define MASK_COLOR(a) ((a) & 0b00001100 << 8)
+#define MASK_BRIGHTNESS(a) ((a) & 0b11110000 << 8)
+
+enum PhysicalType {
+    PEMPTY = 0b0000,    /* Don't render anything */
+    PGROUND = 0b0001,   /* Walkable */
+    PBLINDS = 0b0010,   /* -Energy +Light */
+    PBED = 0b0011,      /* Restart day / spawn */
+    PDOOR = 0b0100,     /* Finish when exit / Big puzzle */
+    PPUZZLE1 = 0b0101,  /* Puzzle for exercise */
+    PPUZZLE2 = 0b0110,  /* Puzzle for fun */
+    PWINDOW = 0b0111,   /* Window for seeing things */
+    PBED_END = 0b1000,  /* Bed part II */
+    PTABLE = 0b1001,    /* You know */
+    PBOSS = 0b1010,     /* You know */
+    PTABLE_TL = 0b1011, /* Main table */
+    PTABLE_BL = 0b1100, /* Main table */
+    PTABLE_TR = 0b1101, /* Main table */
+    PTABLE_BR = 0b1110, /* Main table */
+    // PWALL = 0b1001, /* Window for seeing things */
+};
+
+enum PHeight {
+    UNWALKABLE = 0b00 << 4,
+    H1         = 0b01 << 4,
+    H2         = 0b10 << 4,
+    H3         = 0b11 << 4,
+};
+
+enum VisualType {
+    VEMPTY  = 0b00 << 8,  /* Don't render anything */
+    VSPAWN  = 0b01 << 8,  /* Spawn point */
+};
+
+enum VisualColor {
+    VWHITE = 0b00 << 10,
+    VBLUE = 0b01 << 10,
+    VPINK = 0b10 << 10,
+    VBLACK = 0b11 << 10,
+};
+
+#define VSTRENGTH(a) ((a) << 12)
+#define PMETA(a) ((a) <<  6)
+
+#define S (PBED | H2)
+#define Se (PBED_END | H2 | VSPAWN)
+#define G (PGROUND | H1)
+#define D0 (PDOOR | H1 | PMETA(0b00))
+#define D1 (PDOOR | H1 | PMETA(0b01)) /* Meta roomid */
+#define Db (PBOSS | H1 | PMETA(0b10)) /* Boss door */
+#define P1 (PPUZZLE1 | H2 | VPINK | VSTRENGTH(0b1111))
+#define P2 (PPUZZLE2 | H1 | VBLUE | VSTRENGTH(0b1111))
+#define Ld (PWINDOW | UNWALKABLE | PMETA(0b01) | VWHITE | VSTRENGTH(0b1111)) /* Meta off on */
+#define Lb (PWINDOW | UNWALKABLE | PMETA(0b01) | VPINK | VSTRENGTH(0b0011))  /* Meta off on */
+#define B (PBLINDS | H1)
+#define T (PTABLE | H3)
+#define Tl (PTABLE_TL | H3)
+#define Tr (PTABLE_TR | H3)
+#define Bl (PTABLE_BL | H3)
+#define Br (PTABLE_BR | H3)
+
+/**
+ * Header:
+ * cols, rows
+ * Body: world format (len = width * height)
+ *
+ */
+static u16 worlds[2][103] = {
+    {
+        6, 7,
+        0, 0, 0, 0, D1,0,
+        G, G, G, G, G, G,
+        T, G, G, G, G, G,
+        S, Se,G, G, G ,G,
+        G, G, G, G, G ,G,
+        G, G, G, B, G, G,
+        0, 0, Ld,Ld,0, 0,
+    },
+    {
+        6, 9,
+        0, 0, 0, 0, 0, 0,
+        0, G, G, Tl,Tr,G,
+        Db,G, G, Bl,Br,G,
+        0, G, G, G, P1,G,
+        0, P2,G, G, G, G,
+        0, G, G, G, G, G,
+        0, G, G, G, G, G,
+        0, G, G, G, G, G,
+        0, 0, 0, 0,D0, 0,
+    }
+};
+
+#define WORLD_COUNT (sizeof worlds / sizeof *worlds)
+#define WORLD_CELLS_MAX (sizeof *worlds / sizeof **worlds - 2)  /* Minus header */
+
+#endif  /* WORLD_H */